@@ -26,6 +26,8 @@
  * ---------------------------------------------------------------------
  */
 #pragma once
+#include "Marmot/DisplacementFiniteElementConfig.h"
+#include "Marmot/DisplacementFiniteElementKernels.h"
 #include "Marmot/Marmot.h"
 #include "Marmot/MarmotConstants.h"
 #include "Marmot/MarmotElement.h"
@@ -39,8 +41,17 @@
 #include "Marmot/MarmotStateVarVectorManager.h"
 #include "Marmot/MarmotTypedefs.h"
 #include "Marmot/MarmotVoigt.h"
+#include <algorithm>
 #include <iostream>
+#include <limits>
+#include <map>
 #include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <typeinfo>
 #include <vector>
 
 using namespace Marmot;
@@ -48,6 +59,106 @@ using namespace Eigen;
 
 namespace Marmot::Elements {
 
+  /* Accumulated maximum norms of the quadrature point strain and stress increments of an element
+   * since its last checkpoint; an upper bound estimate for the change of its state */
+  struct StateChangeTracker {
+    double strain = 0.0;
+    double stress = 0.0;
+
+    bool exceeds( double strainTolerance, double stressTolerance ) const
+    {
+      return strain > strainTolerance || stress > stressTolerance;
+    }
+
+    void reset()
+    {
+      strain = 0.0;
+      stress = 0.0;
+    }
+
+    /* a change which is not reflected by the increments, e.g., a reset of the state, always exceeds the tolerances */
+    void markChanged() { strain = std::numeric_limits< double >::infinity(); }
+  };
+
+  /* geostatic stress profile for an interval of the vertical coordinate y, with
+   * sigma_y linearly interpolated between (y1, sigmaY1) and (y2, sigmaY2),
+   * sigma_x = K0x * sigma_y and sigma_z = K0z * sigma_y;
+   * same order as the values for the initial condition GeostaticStress */
+  struct GeostaticStressLayer {
+    double sigmaY1;
+    double y1;
+    double sigmaY2;
+    double y2;
+    double K0x;
+    double K0z;
+  };
+
+  /* squared L2 norms over an element of the difference between recovered and quadrature point stresses,
+   * and of the quadrature point stresses themselves, for Zienkiewicz-Zhu type error estimation */
+  struct StressErrorIndicator {
+    double errorSquared;
+    double stressSquared;
+  };
+
+  /* quantities integrated over an element (or a block of elements) during computeYourself:
+   * the volume, the strain energy increment (trapezoidal rule) and the volume integral of the stress */
+  struct IntegratedQuantities {
+    double   volume                = 0.0;
+    double   strainEnergyIncrement = 0.0;
+    Vector6d stressIntegral        = Vector6d::Zero();
+
+    Vector6d getMeanStress() const { return volume > 0 ? Vector6d( stressIntegral / volume ) : Vector6d::Zero(); }
+
+    IntegratedQuantities& operator+=( const IntegratedQuantities& other )
+    {
+      volume += other.volume;
+      strainEnergyIncrement += other.strainEnergyIncrement;
+      stressIntegral += other.stressIntegral;
+      return *this;
+    }
+  };
+
+  /* Dispatch of the material update to the material type Material:
+   * for a concrete material type, the calls are qualified and hence resolved at compile time,
+   * such that the material update can be inlined into the element loop;
+   * for MarmotMaterialHypoElastic, the calls remain virtual.
+   * The material must be exactly of type Material, not of a type derived from it.
+   * */
+  template < class Material >
+  struct MaterialDispatch {
+
+    static_assert( std::is_base_of_v< MarmotMaterialHypoElastic, Material > );
+
+    static constexpr bool isVirtual = std::is_same_v< Material, MarmotMaterialHypoElastic >;
+
+    template < class... Args >
+    static void computeStress( MarmotMaterialHypoElastic& material, Args&&... args )
+    {
+      if constexpr ( isVirtual )
+        material.computeStress( std::forward< Args >( args )... );
+      else
+        static_cast< Material& >( material ).Material::computeStress( std::forward< Args >( args )... );
+    }
+
+    template < class... Args >
+    static void computePlaneStress( MarmotMaterialHypoElastic& material, Args&&... args )
+    {
+      if constexpr ( isVirtual )
+        material.computePlaneStress( std::forward< Args >( args )... );
+      else
+        static_cast< Material& >( material ).Material::computePlaneStress( std::forward< Args >( args )... );
+    }
+
+    template < class... Args >
+    static void computeUniaxialStress( MarmotMaterialHypoElastic& material, Args&&... args )
+    {
+      if constexpr ( isVirtual )
+        material.computeUniaxialStress( std::forward< Args >( args )... );
+      else
+        static_cast< Material& >( material ).Material::computeUniaxialStress( std::forward< Args >( args )... );
+    }
+  };
+
   template < int nDim, int nNodes >
   class DisplacementFiniteElement : public MarmotElement, public MarmotGeometryElement< nDim, nNodes > {
 
@@ -59,6 +170,15 @@ namespace Marmot::Elements {
       Solid,
     };
 
+    /* BBar: mean dilatation (B-bar) against volumetric locking of nearly incompressible materials,
+     * with the volumetric strain replaced by its element mean, folded into B at initialization;
+     * for plane strain, only the in-plane normal strains are corrected (by the in-plane dilatation / 2);
+     * this is not a mixed displacement-pressure (hybrid) formulation, and it requires a finite bulk stiffness */
+    enum Formulation {
+      Displacement,
+      BBar,
+    };
+
     static constexpr int sizeLoadVector = nNodes * nDim;
     static constexpr int nCoordinates   = nNodes * nDim;
 
@@ -71,19 +191,47 @@ namespace Marmot::Elements {
     using KeSizedMatrix         = Matrix< double, sizeLoadVector, sizeLoadVector >;
     using CSized                = Matrix< double, ParentGeometryElement::voigtSize, ParentGeometryElement::voigtSize >;
     using Voigt                 = Matrix< double, ParentGeometryElement::voigtSize, 1 >;
+    using Kernels               = DisplacementFiniteElementKernels::ClosedForm< nDim, nNodes >;
+
+    /* precision of the quadrature point geometry B; with single precision storage (opt-in, cf. module.cmake),
+     * B is cast to double precision for all products, and Ke and Pe are accumulated in double precision */
+#ifdef DISPLACEMENTFINITEELEMENT_SINGLE_PRECISION_GEOMETRY
+    using GeometryScalar = float;
+#else
+    using GeometryScalar = double;
+#endif
+    using BStorage = Matrix< GeometryScalar, BSized::RowsAtCompileTime, BSized::ColsAtCompileTime >;
+
+    /* switch between the closed form kernels and the generic Eigen expressions for Ke and Pe */
+    inline static bool useClosedFormKernels = false;
+
+    /* isotropic linear elastic sections (LINEARELASTIC with Young's modulus and Poisson's ratio) are evaluated
+     * in closed form, without material objects and without material state vars at the quadrature points */
+    inline static bool useLinearElasticFastPath = true;
 
     Map< const VectorXd > elementProperties;
     const int             elLabel;
     const SectionType     sectionType;
+    const Formulation     formulation;
 
-    struct QuadraturePoint {
+    double* elementStateVars;
+    int     nElementStateVars;
 
-      const XiSized xi;
-      const double  weight;
+    StateChangeTracker stateChangeSinceCheckpoint;
+
+    /* integrated quantities of the most recent call of computeYourself */
+    IntegratedQuantities integratedQuantities;
+
+    /* The data of the quadrature points is split into the hot part, which is accessed in every computeYourself,
+     * and the cold part, which is only required for initialization and output.
+     * The hot part is aligned and padded to cache lines. */
+    struct alignas( 64 ) QuadraturePoint {
 
-      double detJ;
-      double J0xW;
-      BSized B;
+      BStorage B;
+      double   J0xW;
+
+      /* inactive quadrature points are skipped in computeYourself, e.g., in hyper-reduced models */
+      bool isActive;
 
       class QPStateVarManager : public MarmotStateVarVectorManager {
 
@@ -119,25 +267,58 @@ namespace Marmot::Elements {
 
       int getNumberOfRequiredStateVars()
       {
-        return getNumberOfRequiredStateVarsQuadraturePointOnly() + material->getNumberOfRequiredStateVars();
+        return getNumberOfRequiredStateVarsQuadraturePointOnly() +
+               ( material ? material->getNumberOfRequiredStateVars() : 0 );
       };
 
       void assignStateVars( double* stateVars, int nStateVars )
       {
         managedStateVars = std::make_unique< QPStateVarManager >( stateVars, nStateVars );
-        material->assignStateVars( managedStateVars->materialStateVars.data(),
-                                   managedStateVars->materialStateVars.size() );
+        if ( material )
+          material->assignStateVars( managedStateVars->materialStateVars.data(),
+                                     managedStateVars->materialStateVars.size() );
       }
 
-      QuadraturePoint( XiSized xi, double weight )
-        : xi( xi ), weight( weight ), detJ( 0.0 ), J0xW( 0.0 ), B( BSized::Zero() ){};
+      QuadraturePoint() : B( BStorage::Zero() ), J0xW( 0.0 ), isActive( true ){};
+    };
+
+    struct ColdQuadraturePointData {
+
+      const XiSized xi;
+      const double  weight;
+
+      double  detJ;
+      XiSized coordinates;
+
+      /* J0xW of the full quadrature rule, kept for resetting a reduced quadrature */
+      double referenceJ0xW;
+
+      ColdQuadraturePointData( XiSized xi, double weight )
+        : xi( xi ), weight( weight ), detJ( 0.0 ), coordinates( XiSized::Zero() ), referenceJ0xW( 0.0 ){};
     };
 
-    std::vector< QuadraturePoint > qps;
+    std::pmr::vector< QuadraturePoint >         qps;
+    std::pmr::vector< ColdQuadraturePointData > qpsCold;
 
+    XiSized centerCoordinates;
+
+    /* extrapolation from the quadrature points to the nodes (nNodes x nQuadraturePoints),
+     * shared by all elements with the same quadrature rule (cf. getQuadraturePointToNodeExtrapolation) */
+    const MatrixXd* qpToNodeExtrapolation;
+
+    /* the quadrature points (including their geometry) are allocated from memoryResource (if not a nullptr),
+     * e.g., a Memory::HugePageArena shared by all elements of a large model */
     DisplacementFiniteElement( int                                         elementID,
                                FiniteElement::Quadrature::IntegrationTypes integrationType,
-                               SectionType                                 sectionType );
+                               SectionType                                 sectionType,
+                               Formulation                                 formulation    = Displacement,
+                               std::pmr::memory_resource*                  memoryResource = nullptr );
+
+    /* clone of the reference data (section, formulation and quadrature rule) of a prototype,
+     * without a repeated setup of the quadrature rule; e.g., for bulk construction of elements */
+    DisplacementFiniteElement( int                              elementID,
+                               const DisplacementFiniteElement& prototype,
+                               std::pmr::memory_resource*       memoryResource = nullptr );
 
     int getNumberOfRequiredStateVars();
 
@@ -165,6 +346,10 @@ namespace Marmot::Elements {
 
     void setInitialConditions( StateTypes state, const double* values );
 
+    /* for each quadrature point, the first layer containing its vertical coordinate is applied;
+     * if none does, the closest layer is extrapolated */
+    void setGeostaticStress( const GeostaticStressLayer* layers, int nLayers );
+
     void computeDistributedLoad( MarmotElement::DistributedLoadTypes loadType,
                                  double*                             P,
                                  double*                             K,
@@ -189,6 +374,92 @@ namespace Marmot::Elements {
                           double        dT,
                           double&       pNewdT );
 
+    /* computeYourself with the material update statically dispatched to Material (cf. MaterialDispatch),
+     * which must be the exact type of the materials of all quadrature points (cf. hasMaterialType) */
+    template < class Material >
+    void computeYourselfWithMaterial( const double* QTotal,
+                                      const double* dQ,
+                                      double*       Pe,
+                                      double*       Ke,
+                                      const double* time,
+                                      double        dT,
+                                      double&       pNewdT );
+
+    /* true if the materials of all quadrature points are exactly of type Material,
+     * or if the section is evaluated by the linear elastic fast path */
+    template < class Material >
+    bool hasMaterialType() const
+    {
+      if constexpr ( MaterialDispatch< Material >::isVirtual )
+        return true;
+      else if ( linearElastic )
+        return true;
+      else
+        return std::all_of( qps.begin(), qps.end(), []( const QuadraturePoint& qp ) {
+          return qp.material && typeid( *qp.material ) == typeid( Material );
+        } );
+    }
+
+    /* same as computeYourself, but the resulting trial state is kept in a scratch buffer,
+     * and the committed state vars remain untouched, e.g., for evaluating residuals in line searches;
+     * the state of the most recent trial can be committed by acceptTrial, as long as it is still current,
+     * i.e., a trial is discarded by acceptTrial, and by any subsequent computeYourself, activate or deactivate;
+     * the integrated quantities remain those of the committed state until the trial is accepted;
+     * if the evaluation throws, the committed state is restored */
+    void computeTrial( const double* QTotal,
+                       const double* dQ,
+                       double*       Pe,
+                       double*       Ke,
+                       const double* time,
+                       double        dT,
+                       double&       pNewdT );
+
+    void acceptTrial();
+
+    /* birth and death of elements: an inactive element is skipped by element blocks,
+     * and its computeYourself, computeDistributedLoad and computeBodyForce are no-ops, i.e., a removed element
+     * neither contributes stiffness nor loads;
+     * on reactivation, the element starts from a stress and strain free state with reinitialized material state vars,
+     * using its existing state vars */
+    bool isActive() const { return active; }
+
+    void deactivate();
+
+    void activate();
+
+    /* restore the activation and erosion state, e.g., from a checkpoint on restart;
+     * unlike activate and deactivate, neither the state vars nor the state change tracker are touched */
+    void restoreActivationState( bool isActive, bool isEroded );
+
+    /* erosion of fully failed elements: an element is eroded as soon as the state erosionStateName
+     * (e.g., a damage variable or a failure flag) reaches erosionThreshold at all active quadrature points,
+     * of which there must be at least one;
+     * an eroded element is permanently deactivated;
+     * the state is resolved and validated once (throwing for an unknown state), hence the state vars must be assigned
+     * beforehand, and the criterion must be set again if the material section changes */
+    void setErosionCriterion( const std::string& stateName, double threshold );
+
+    /* check the erosion criterion, e.g., after a converged increment; returns true if the element is eroded */
+    bool updateErosion();
+
+    bool isEroded() const { return eroded; }
+
+    /* residuals Pe_k -= int B^T * ( S + C * B * dQ_k ) dV for nRightHandSides increments dQ_k at once,
+     * with the stress S and the tangent C of the committed state, which remains untouched;
+     * exact for linear sections, e.g., for load case sweeps in linear elastic analyses;
+     * inactive elements do not contribute;
+     * dQ and Pe are column major (sizeLoadVector x nRightHandSides) */
+    void computeLinearResiduals( const double* dQ,
+                                 double*       Pe,
+                                 int           nRightHandSides,
+                                 const double* time,
+                                 double        dT );
+
+    /* internal forces Pe -= int B^T * S dV and stiffness Ke += int B^T * C * B dV of the committed state,
+     * i.e., for a zero increment; neither the state vars, nor a pending trial state, nor the integrated quantities
+     * are changed; inactive elements do not contribute */
+    void computeCommittedResponse( double* Pe, double* Ke, const double* time, double dT );
+
     StateView getStateView( const std::string& stateName, int qpNumber )
     {
       const auto& qp = qps[qpNumber];
@@ -203,6 +474,11 @@ namespace Marmot::Elements {
                  static_cast< int >( qp.managedStateVars->materialStateVars.size() ) };
       }
 
+      else if ( linearElastic ) {
+        throw std::invalid_argument( MakeString() << __PRETTY_FUNCTION__ << ": state " << stateName
+                                                  << " does not exist for the linear elastic fast path" );
+      }
+
       else {
         return qp.material->getStateView( stateName );
       }
@@ -212,23 +488,163 @@ namespace Marmot::Elements {
 
     std::vector< std::vector< double > > getCoordinatesAtQuadraturePoints();
 
+    /* allocation free variants, writing the cached coordinates to a buffer of size nDim
+     * or nDim * nQuadraturePoints, respectively; available after assignNodeCoordinates */
+    void getCoordinatesAtCenter( double* coordinates );
+
+    void getCoordinatesAtQuadraturePoints( double* coordinates );
+
+    /* extrapolate the quadrature point stresses to the nodes, and write them to a buffer of size nNodes * 6;
+     * with a reduced quadrature, the nodal stresses are the J0xW weighted mean of the active quadrature points,
+     * as the inactive ones are not updated */
+    void computeNodalStresses( double* nodalStresses );
+
+    /* compare the quadrature point stresses with the recovered stress field,
+     * interpolated from the given nodal stresses (nNodes * 6); integrated over the active quadrature points */
+    StressErrorIndicator computeStressErrorIndicator( const double* recoveredNodalStresses );
+
+    /* reduced quadrature for hyper-reduced models: sets the activity of each quadrature point,
+     * and overrides J0xW of the active quadrature points (if J0xW is not a nullptr, otherwise the J0xW of the
+     * full quadrature rule is used); inactive quadrature points are skipped in all element integrals */
+    void setQuadraturePointMask( const bool* isActive, const double* J0xW );
+
+    /* restore the full quadrature rule */
+    void resetQuadraturePointMask();
+
+    /* contributions B^T * S * J0xW of each quadrature point to the internal forces at the current state
+     * (sizeLoadVector x nQuadraturePoints), e.g., as training data for selecting a reduced quadrature */
+    void computeQuadraturePointInternalForces( double* qpForces );
+
+    const IntegratedQuantities& getIntegratedQuantities() const { return integratedQuantities; }
+
     int getNumberOfQuadraturePoints();
+
+    /* geometry per quadrature point in the order detJ, J0xW of the full quadrature rule, J0xW, isActive, B,
+     * i.e., including the quadrature point mask of a reduced quadrature;
+     * used for writing checkpoints and restoring from them without reinitialization */
+    static constexpr int nGeometryEntriesQuadraturePoint = 4 + BSized::SizeAtCompileTime;
+
+    int getNumberOfGeometryEntries() { return qps.size() * nGeometryEntriesQuadraturePoint; }
+
+    void exportGeometry( double* geometry );
+
+    void importGeometry( const double* geometry );
+
+    /* move the hot quadrature point data (including B) to a new allocation from memoryResource,
+     * e.g., to lay out the geometry of a block contiguously in the order of its sweeps;
+     * the memory resource must outlive the element */
+    void relocateQuadraturePoints( std::pmr::memory_resource* memoryResource );
+
+  private:
+    bool active;
+    bool eroded;
+
+    // offset of the erosion state in the state vars of a quadrature point, -1 if no criterion is set
+    int    erosionStateOffset;
+    double erosionThreshold;
+
+    bool linearElastic;
+
+    // constant tangent of the linear elastic fast path, set up once in assignProperty
+    CSized linearElasticTangent;
+
+    std::vector< double > trialStateVars;
+    StateChangeTracker    trialStateChangeSinceCheckpoint;
+    IntegratedQuantities  trialIntegratedQuantities;
+
+    // committed material state of a quadrature point, cf. computeCommittedMaterialResponse
+    std::vector< double > committedMaterialStateVars;
+
+    template < class Material = MarmotMaterialHypoElastic >
+    void computeMaterialResponse( QuadraturePoint& qp,
+                                  const Voigt&     dE,
+                                  Voigt&           S,
+                                  CSized&          C,
+                                  const double*    time,
+                                  double           dT,
+                                  double&          pNewDT );
+
+    void computeLinearElasticResponse( QuadraturePoint& qp, const Voigt& dE, Voigt& S, CSized& C );
+
+    /* stress S of the committed state, and the tangent C of the material response to a zero increment;
+     * the state vars of the quadrature point remain untouched */
+    void computeCommittedMaterialResponse( QuadraturePoint& qp, Voigt& S, CSized& C, const double* time, double dT );
+
+    /* cache the coordinates of the center and the quadrature points, as soon as the node coordinates are known */
+    void computeCoordinatesAtQuadraturePoints();
+
+    /* The extrapolation reproduces at least constant fields:
+     *  - a single quadrature point is extrapolated constantly
+     *  - for at least as many quadrature points as nodes, the shape functions are fitted in the least squares sense
+     *  - otherwise (reduced integration of serendipity elements), the (multi)linear interpolation of the corner nodes
+     *    is fitted, and evaluated at all nodes; i.e., midside nodes are interpolated from the adjacent corner nodes
+     * */
+    const MatrixXd& getQuadraturePointToNodeExtrapolation();
+
+    /* natural coordinates of the nodes (nDim x nNodes), with the corner nodes first */
+    static Matrix< double, nDim, nNodes > getNodeNaturalCoordinates();
   };
 
   template < int nDim, int nNodes >
   DisplacementFiniteElement< nDim, nNodes >::DisplacementFiniteElement(
     int                                         elementID,
     FiniteElement::Quadrature::IntegrationTypes integrationType,
-    SectionType                                 sectionType )
+    SectionType                                 sectionType,
+    Formulation                                 formulation,
+    std::pmr::memory_resource*                  memoryResource )
     : ParentGeometryElement(),
       elementProperties( Map< const VectorXd >( nullptr, 0 ) ),
       elLabel( elementID ),
-      sectionType( sectionType )
+      sectionType( sectionType ),
+      formulation( formulation ),
+      elementStateVars( nullptr ),
+      nElementStateVars( 0 ),
+      qps( memoryResource ? memoryResource : std::pmr::get_default_resource() ),
+      qpsCold( memoryResource ? memoryResource : std::pmr::get_default_resource() ),
+      centerCoordinates( XiSized::Zero() ),
+      qpToNodeExtrapolation( nullptr ),
+      active( true ),
+      eroded( false ),
+      erosionStateOffset( -1 ),
+      erosionThreshold( 0.0 ),
+      linearElastic( false ),
+      linearElasticTangent( CSized::Zero() )
+  {
+    if ( formulation == BBar && !( sectionType == PlaneStrain || sectionType == Solid ) )
+      throw std::invalid_argument( MakeString() << __PRETTY_FUNCTION__
+                                                << ": B-bar formulation requires plane strain or solid sections" );
+
+    const auto gaussPointInfo = FiniteElement::Quadrature::getGaussPointInfo( this->shape, integrationType );
+    qps.resize( gaussPointInfo.size() );
+    qpsCold.reserve( gaussPointInfo.size() );
+
+    for ( const auto& qpInfo : gaussPointInfo )
+      qpsCold.emplace_back( qpInfo.xi, qpInfo.weight );
+  }
+
+  template < int nDim, int nNodes >
+  DisplacementFiniteElement< nDim, nNodes >::DisplacementFiniteElement(
+    int                              elementID,
+    const DisplacementFiniteElement& prototype,
+    std::pmr::memory_resource*       memoryResource )
+    : ParentGeometryElement(),
+      elementProperties( Map< const VectorXd >( nullptr, 0 ) ),
+      elLabel( elementID ),
+      sectionType( prototype.sectionType ),
+      formulation( prototype.formulation ),
+      elementStateVars( nullptr ),
+      nElementStateVars( 0 ),
+      qps( prototype.qps.size(), memoryResource ? memoryResource : std::pmr::get_default_resource() ),
+      qpsCold( prototype.qpsCold, memoryResource ? memoryResource : std::pmr::get_default_resource() ),
+      centerCoordinates( XiSized::Zero() ),
+      qpToNodeExtrapolation( nullptr ),
+      active( true ),
+      eroded( false ),
+      erosionStateOffset( -1 ),
+      erosionThreshold( 0.0 ),
+      linearElastic( false ),
+      linearElasticTangent( CSized::Zero() )
   {
-    for ( const auto& qpInfo : FiniteElement::Quadrature::getGaussPointInfo( this->shape, integrationType ) ) {
-      QuadraturePoint qp( qpInfo.xi, qpInfo.weight );
-      qps.push_back( std::move( qp ) );
-    }
   }
 
   template < int nDim, int nNodes >
@@ -266,6 +682,9 @@ namespace Marmot::Elements {
   template < int nDim, int nNodes >
   void DisplacementFiniteElement< nDim, nNodes >::assignStateVars( double* stateVars, int nStateVars )
   {
+    elementStateVars  = stateVars;
+    nElementStateVars = nStateVars;
+
     const int nQpStateVars = nStateVars / qps.size();
 
     for ( size_t i = 0; i < qps.size(); i++ ) {
@@ -285,7 +704,64 @@ namespace Marmot::Elements {
   template < int nDim, int nNodes >
   void DisplacementFiniteElement< nDim, nNodes >::assignProperty( const MarmotMaterialSection& section )
   {
-    for ( auto& qp : qps ) {
+    // looked up once; if the linear elastic material is not registered, the fast path is disabled for good
+    static const std::optional< int > linearElasticCode = []() -> std::optional< int > {
+      try {
+        return MarmotLibrary::MarmotMaterialFactory::getMaterialCodeFromName( "LINEARELASTIC" );
+      }
+      catch ( const std::exception& ) {
+        return std::nullopt;
+      }
+    }();
+
+    linearElastic = useLinearElasticFastPath && linearElasticCode && section.materialCode == *linearElasticCode &&
+                    section.nMaterialProperties == 2;
+
+    if ( linearElastic ) {
+      const double E  = section.materialProperties[0];
+      const double nu = section.materialProperties[1];
+
+      // the Lame constant lambda diverges for the incompressible limit
+      if ( nu >= 0.5 )
+        throw std::invalid_argument( MakeString() << __PRETTY_FUNCTION__ << ": element " << elLabel
+                                                  << ": Poisson's ratio must be less than 0.5" );
+
+      const double G      = E / ( 2 * ( 1 + nu ) );
+      const double lambda = E * nu / ( ( 1 + nu ) * ( 1 - 2 * nu ) );
+
+      CSized& C = linearElasticTangent;
+      C.setZero();
+
+      if constexpr ( nDim == 1 )
+        C( 0, 0 ) = E;
+
+      else if constexpr ( nDim == 2 ) {
+        if ( sectionType == SectionType::PlaneStress ) {
+          const double Ep = E / ( 1 - nu * nu );
+          C.template topLeftCorner< 2, 2 >().setConstant( Ep * nu );
+          C.diagonal() << Ep, Ep, G;
+        }
+        else if ( sectionType == SectionType::PlaneStrain ) {
+          C.template topLeftCorner< 2, 2 >().setConstant( lambda );
+          C.diagonal() << lambda + 2 * G, lambda + 2 * G, G;
+        }
+      }
+
+      else if constexpr ( nDim == 3 ) {
+        C.template topLeftCorner< 3, 3 >().setConstant( lambda );
+        C.diagonal() << lambda + 2 * G, lambda + 2 * G, lambda + 2 * G, G, G, G;
+      }
+
+      for ( QuadraturePoint& qp : qps )
+        qp.material.reset();
+
+      return;
+    }
+
+    for ( size_t i = 0; i < qps.size(); i++ ) {
+      auto&        qp   = qps[i];
+      const double detJ = qpsCold[i].detJ;
+
       qp.material = std::unique_ptr< MarmotMaterialHypoElastic >( dynamic_cast< MarmotMaterialHypoElastic* >(
         MarmotLibrary::MarmotMaterialFactory::createMaterial( section.materialCode,
                                                               section.materialProperties,
@@ -298,11 +774,11 @@ namespace Marmot::Elements {
                                      << ": invalid material assigned; cannot cast to MarmotMaterialHypoElastic!" );
 
       if constexpr ( nDim == 3 )
-        qp.material->setCharacteristicElementLength( std::cbrt( 8 * qp.detJ ) );
+        qp.material->setCharacteristicElementLength( std::cbrt( 8 * detJ ) );
       if constexpr ( nDim == 2 )
-        qp.material->setCharacteristicElementLength( std::sqrt( 4 * qp.detJ ) );
+        qp.material->setCharacteristicElementLength( std::sqrt( 4 * detJ ) );
       if constexpr ( nDim == 1 )
-        qp.material->setCharacteristicElementLength( 2 * qp.detJ );
+        qp.material->setCharacteristicElementLength( 2 * detJ );
     }
   }
 
@@ -310,41 +786,286 @@ namespace Marmot::Elements {
   void DisplacementFiniteElement< nDim, nNodes >::assignNodeCoordinates( const double* coordinates )
   {
     ParentGeometryElement::assignNodeCoordinates( coordinates );
+
+    computeCoordinatesAtQuadraturePoints();
   }
 
   template < int nDim, int nNodes >
   void DisplacementFiniteElement< nDim, nNodes >::initializeYourself()
   {
-    for ( QuadraturePoint& qp : qps ) {
-      const dNdXiSized    dNdXi = this->dNdXi( qp.xi );
+    // volumetric part of B (the divergence operator), and its mean over the element for the B-bar formulation
+    using DivergenceSized = Matrix< double, 1, sizeLoadVector >;
+    std::vector< DivergenceSized > divergence( qps.size() );
+    DivergenceSized                meanDivergence = DivergenceSized::Zero();
+    double                         volume         = 0.0;
+
+    for ( size_t i = 0; i < qps.size(); i++ ) {
+      QuadraturePoint&         qp     = qps[i];
+      ColdQuadraturePointData& qpCold = qpsCold[i];
+
+      const dNdXiSized    dNdXi = this->dNdXi( qpCold.xi );
       const JacobianSized J     = this->Jacobian( dNdXi );
       const JacobianSized JInv  = J.inverse();
       const dNdXiSized    dNdX  = this->dNdX( dNdXi, JInv );
-      qp.detJ                   = J.determinant();
-      qp.B                      = this->B( dNdX );
+      qpCold.detJ               = J.determinant();
+      const BSized        B     = this->B( dNdX );
+      qp.B                      = B.template cast< GeometryScalar >();
+
+      divergence[i] = B.topRows( nDim ).colwise().sum();
+      meanDivergence += divergence[i] * qpCold.weight * qpCold.detJ;
+      volume += qpCold.weight * qpCold.detJ;
 
       if constexpr ( nDim == 3 ) {
-        qp.J0xW = qp.weight * qp.detJ;
+        qp.J0xW = qpCold.weight * qpCold.detJ;
       }
       if constexpr ( nDim == 2 ) {
         const double& thickness = elementProperties[0];
-        qp.J0xW                 = qp.weight * qp.detJ * thickness;
+        qp.J0xW                 = qpCold.weight * qpCold.detJ * thickness;
       }
       if constexpr ( nDim == 1 ) {
         const double& crossSection = elementProperties[0];
-        qp.J0xW                    = qp.weight * qp.detJ * crossSection;
+        qp.J0xW                    = qpCold.weight * qpCold.detJ * crossSection;
+      }
+
+      qpCold.referenceJ0xW = qp.J0xW;
+    }
+
+    if ( formulation == BBar ) {
+      meanDivergence /= volume;
+
+      // replace the volumetric part of the normal strains by its mean;
+      // for plane strain, the out of plane strain remains zero, i.e., only the in-plane normal strains are corrected
+      for ( size_t i = 0; i < qps.size(); i++ ) {
+        const DivergenceSized correction = ( meanDivergence - divergence[i] ) / nDim;
+        qps[i].B.topRows( nDim ).rowwise() += correction.template cast< GeometryScalar >();
+      }
+    }
+
+    qpToNodeExtrapolation = &getQuadraturePointToNodeExtrapolation();
+  }
+
+  template < int nDim, int nNodes >
+  const MatrixXd& DisplacementFiniteElement< nDim, nNodes >::getQuadraturePointToNodeExtrapolation()
+  {
+    // the quadrature rules of an element type are distinguished by their number of quadrature points
+    static std::mutex                   mutex;
+    static std::map< size_t, MatrixXd > extrapolations;
+
+    std::lock_guard< std::mutex > lock( mutex );
+
+    auto extrapolation = extrapolations.find( qps.size() );
+    if ( extrapolation != extrapolations.end() )
+      return extrapolation->second;
+
+    constexpr int nCornerNodes = 1 << nDim;
+    const int     nQps         = static_cast< int >( qps.size() );
+
+    MatrixXd E( nNodes, nQps );
+
+    if ( nQps == 1 )
+      E.setOnes();
+
+    else if ( nQps >= nNodes ) {
+      MatrixXd N( nQps, nNodes );
+      for ( int i = 0; i < nQps; i++ )
+        N.row( i ) = this->N( qpsCold[i].xi );
+
+      E = N.completeOrthogonalDecomposition().pseudoInverse();
+    }
+
+    else if ( nQps >= nCornerNodes ) {
+      const Matrix< double, nDim, nNodes > nodes = getNodeNaturalCoordinates();
+
+      // (multi)linear shape functions of the corner nodes
+      auto cornerN = [&]( const XiSized& xi ) {
+        Matrix< double, 1, nCornerNodes > N;
+        for ( int a = 0; a < nCornerNodes; a++ ) {
+          N( a ) = 1.0;
+          for ( int k = 0; k < nDim; k++ )
+            N( a ) *= 0.5 * ( 1 + nodes( k, a ) * xi( k ) );
+        }
+        return N;
+      };
+
+      MatrixXd NCorner( nQps, nCornerNodes );
+      for ( int i = 0; i < nQps; i++ )
+        NCorner.row( i ) = cornerN( qpsCold[i].xi );
+
+      const MatrixXd cornerExtrapolation = NCorner.completeOrthogonalDecomposition().pseudoInverse();
+
+      for ( int a = 0; a < nNodes; a++ )
+        E.row( a ) = cornerN( nodes.col( a ) ) * cornerExtrapolation;
+    }
+
+    else
+      throw std::invalid_argument( MakeString() << __PRETTY_FUNCTION__ << ": no extrapolation for " << nQps
+                                                << " quadrature points and " << nNodes << " nodes" );
+
+    if ( ( E.rowwise().sum().array() - 1.0 ).abs().maxCoeff() > 1e-10 )
+      throw std::runtime_error( MakeString() << __PRETTY_FUNCTION__
+                                             << ": extrapolation does not reproduce constant fields" );
+
+    return extrapolations.emplace( qps.size(), std::move( E ) ).first->second;
+  }
+
+  template < int nDim, int nNodes >
+  Matrix< double, nDim, nNodes > DisplacementFiniteElement< nDim, nNodes >::getNodeNaturalCoordinates()
+  {
+    // node numbering of Abaqus: corner nodes counterclockwise (bottom face first), followed by the midside nodes
+    static constexpr double corners[8][3] = { { -1, -1, -1 },
+                                              { 1, -1, -1 },
+                                              { 1, 1, -1 },
+                                              { -1, 1, -1 },
+                                              { -1, -1, 1 },
+                                              { 1, -1, 1 },
+                                              { 1, 1, 1 },
+                                              { -1, 1, 1 } };
+
+    static constexpr double midsides[12][3] = { { 0, -1, -1 },
+                                                { 1, 0, -1 },
+                                                { 0, 1, -1 },
+                                                { -1, 0, -1 },
+                                                { 0, -1, 1 },
+                                                { 1, 0, 1 },
+                                                { 0, 1, 1 },
+                                                { -1, 0, 1 },
+                                                { -1, -1, 0 },
+                                                { 1, -1, 0 },
+                                                { 1, 1, 0 },
+                                                { -1, 1, 0 } };
+
+    constexpr int nCornerNodes = 1 << nDim;
+
+    if constexpr ( !( nNodes == nCornerNodes || ( nDim == 2 && nNodes == 8 ) || ( nDim == 3 && nNodes == 20 ) ) )
+      throw std::invalid_argument( MakeString() << __PRETTY_FUNCTION__ << ": unsupported element type" );
+
+    Matrix< double, nDim, nNodes > nodes;
+    for ( int a = 0; a < nNodes; a++ )
+      for ( int k = 0; k < nDim; k++ )
+        nodes( k, a ) = a < nCornerNodes ? corners[a][k] : midsides[a - nCornerNodes][k];
+
+    return nodes;
+  }
+
+  template < int nDim, int nNodes >
+  void DisplacementFiniteElement< nDim, nNodes >::computeCoordinatesAtQuadraturePoints()
+  {
+    for ( ColdQuadraturePointData& qpCold : qpsCold )
+      qpCold.coordinates = this->NB( this->N( qpCold.xi ) ) * this->coordinates;
+
+    centerCoordinates = this->NB( this->N( XiSized::Zero() ) ) * this->coordinates;
+  }
+
+  template < int nDim, int nNodes >
+  template < class Material >
+  void DisplacementFiniteElement< nDim, nNodes >::computeMaterialResponse( QuadraturePoint& qp,
+                                                                           const Voigt&     dE,
+                                                                           Voigt&           S,
+                                                                           CSized&          C,
+                                                                           const double*    time,
+                                                                           double           dT,
+                                                                           double&          pNewDT )
+  {
+    using namespace ContinuumMechanics::VoigtNotation;
+    using Dispatch = MaterialDispatch< Material >;
+
+    if ( linearElastic ) {
+      computeLinearElasticResponse( qp, dE, S, C );
+      return;
+    }
+
+    if constexpr ( nDim == 1 ) {
+
+      S = reduce3DVoigt< ParentGeometryElement::voigtSize >( qp.managedStateVars->stress );
+      Dispatch::computeUniaxialStress( *qp.material, S.data(), C.data(), dE.data(), time, dT, pNewDT );
+      qp.managedStateVars->stress = make3DVoigt< ParentGeometryElement::voigtSize >( S );
+    }
+
+    else if constexpr ( nDim == 2 ) {
+
+      if ( sectionType == SectionType::PlaneStress ) {
+
+        S = reduce3DVoigt< ParentGeometryElement::voigtSize >( qp.managedStateVars->stress );
+        Dispatch::computePlaneStress( *qp.material, S.data(), C.data(), dE.data(), time, dT, pNewDT );
+        qp.managedStateVars->stress = make3DVoigt< ParentGeometryElement::voigtSize >( S );
+      }
+
+      else if ( sectionType == SectionType::PlaneStrain ) {
+
+        Vector6d dE6 = planeVoigtToVoigt( dE );
+        Matrix6d C66;
+
+        Vector6d S6 = qp.managedStateVars->stress;
+        Dispatch::computeStress( *qp.material, S6.data(), C66.data(), dE6.data(), time, dT, pNewDT );
+        qp.managedStateVars->stress = S6;
+
+        S = reduce3DVoigt< ParentGeometryElement::voigtSize >( S6 );
+        C = ContinuumMechanics::PlaneStrain::getPlaneStrainTangent( C66 );
+      }
+    }
+
+    else if constexpr ( nDim == 3 ) {
+      if ( sectionType == SectionType::Solid ) {
+
+        S = qp.managedStateVars->stress;
+        Dispatch::computeStress( *qp.material, S.data(), C.data(), dE.data(), time, dT, pNewDT );
+        qp.managedStateVars->stress = S;
       }
     }
   }
 
   template < int nDim, int nNodes >
-  void DisplacementFiniteElement< nDim, nNodes >::computeYourself( const double* QTotal_,
-                                                                   const double* dQ_,
-                                                                   double*       Pe_,
-                                                                   double*       Ke_,
+  void DisplacementFiniteElement< nDim, nNodes >::computeLinearElasticResponse( QuadraturePoint& qp,
+                                                                                const Voigt&     dE,
+                                                                                Voigt&           S,
+                                                                                CSized&          C )
+  {
+    using namespace ContinuumMechanics::VoigtNotation;
+
+    mVector6d& stress = qp.managedStateVars->stress;
+
+    C = linearElasticTangent;
+
+    if constexpr ( nDim == 3 ) {
+      stress += C * dE;
+      S = stress;
+    }
+
+    else {
+      // the out of plane normal stress of plane strain is not contained in the plane Voigt notation
+      double stress33 = 0.0;
+      if constexpr ( nDim == 2 )
+        stress33 = stress( 2 ) + C( 0, 1 ) * ( dE( 0 ) + dE( 1 ) );
+
+      S      = reduce3DVoigt< ParentGeometryElement::voigtSize >( stress ) + C * dE;
+      stress = make3DVoigt< ParentGeometryElement::voigtSize >( S );
+
+      if ( sectionType == SectionType::PlaneStrain )
+        stress( 2 ) = stress33;
+    }
+  }
+
+  template < int nDim, int nNodes >
+  void DisplacementFiniteElement< nDim, nNodes >::computeYourself( const double* QTotal,
+                                                                   const double* dQ,
+                                                                   double*       Pe,
+                                                                   double*       Ke,
                                                                    const double* time,
                                                                    double        dT,
                                                                    double&       pNewDT )
+  {
+    computeYourselfWithMaterial< MarmotMaterialHypoElastic >( QTotal, dQ, Pe, Ke, time, dT, pNewDT );
+  }
+
+  template < int nDim, int nNodes >
+  template < class Material >
+  void DisplacementFiniteElement< nDim, nNodes >::computeYourselfWithMaterial( const double* QTotal_,
+                                                                               const double* dQ_,
+                                                                               double*       Pe_,
+                                                                               double*       Ke_,
+                                                                               const double* time,
+                                                                               double        dT,
+                                                                               double&       pNewDT )
   {
     using namespace Marmot;
     using namespace ContinuumMechanics::VoigtNotation;
@@ -357,85 +1078,294 @@ namespace Marmot::Elements {
     Voigt  S, dE;
     CSized C;
 
+    double maxStrainChange = 0.0;
+    double maxStressChange = 0.0;
+
+    integratedQuantities = IntegratedQuantities();
+
+    // the committed state changes, hence a pending trial is outdated
+    trialStateVars.clear();
+
+    if ( !active )
+      return;
+
     for ( QuadraturePoint& qp : qps ) {
 
-      const BSized& B = qp.B;
-      dE              = B * dQ;
+      if ( !qp.isActive )
+        continue;
 
-      if constexpr ( nDim == 1 ) {
+      const auto& B = qp.B.template cast< double >();
+      dE            = B * dQ;
 
-        S = reduce3DVoigt< ParentGeometryElement::voigtSize >( qp.managedStateVars->stress );
-        qp.material->computeUniaxialStress( S.data(), C.data(), dE.data(), time, dT, pNewDT );
-        qp.managedStateVars->stress = make3DVoigt< ParentGeometryElement::voigtSize >( S );
-      }
+      const Vector6d stressOld = qp.managedStateVars->stress;
 
-      else if constexpr ( nDim == 2 ) {
+      computeMaterialResponse< Material >( qp, dE, S, C, time, dT, pNewDT );
 
-        if ( sectionType == SectionType::PlaneStress ) {
+      qp.managedStateVars->strain += make3DVoigt< ParentGeometryElement::voigtSize >( dE );
 
-          S = reduce3DVoigt< ParentGeometryElement::voigtSize >( qp.managedStateVars->stress );
-          qp.material->computePlaneStress( S.data(), C.data(), dE.data(), time, dT, pNewDT );
-          qp.managedStateVars->stress = make3DVoigt< ParentGeometryElement::voigtSize >( S );
-        }
+      maxStrainChange = std::max( maxStrainChange, dE.norm() );
+      maxStressChange = std::max( maxStressChange, ( qp.managedStateVars->stress - stressOld ).norm() );
 
-        else if ( sectionType == SectionType::PlaneStrain ) {
+      if ( pNewDT < 1.0 )
+        break;
 
-          Vector6d dE6 = planeVoigtToVoigt( dE );
-          Matrix6d C66;
+      const Voigt SOld = reduce3DVoigt< ParentGeometryElement::voigtSize >( stressOld );
 
-          Vector6d S6 = qp.managedStateVars->stress;
-          qp.material->computeStress( S6.data(), C66.data(), dE6.data(), time, dT, pNewDT );
-          qp.managedStateVars->stress = S6;
+      integratedQuantities.volume += qp.J0xW;
+      integratedQuantities.strainEnergyIncrement += 0.5 * ( SOld + S ).dot( dE ) * qp.J0xW;
+      integratedQuantities.stressIntegral += qp.managedStateVars->stress * qp.J0xW;
 
-          S = reduce3DVoigt< ParentGeometryElement::voigtSize >( S6 );
-          C = ContinuumMechanics::PlaneStrain::getPlaneStrainTangent( C66 );
-        }
+      // the closed form kernels rely on the sparsity of the standard B, which does not hold for B-bar elements
+      if ( useClosedFormKernels && formulation == Displacement ) {
+        Kernels::accumulateStiffness( B, C, qp.J0xW, Ke );
+        Kernels::accumulateInternalForce( B, S, qp.J0xW, Pe );
       }
 
-      else if constexpr ( nDim == 3 ) {
-        if ( sectionType == SectionType::Solid ) {
-
-          S = qp.managedStateVars->stress;
-          qp.material->computeStress( S.data(), C.data(), dE.data(), time, dT, pNewDT );
-          qp.managedStateVars->stress = S;
-        }
+      else {
+        Ke += B.transpose() * C * B * qp.J0xW;
+        Pe -= B.transpose() * S * qp.J0xW;
       }
+    }
 
-      qp.managedStateVars->strain += make3DVoigt< ParentGeometryElement::voigtSize >( dE );
+    stateChangeSinceCheckpoint.strain += maxStrainChange;
+    stateChangeSinceCheckpoint.stress += maxStressChange;
+  }
 
-      if ( pNewDT < 1.0 )
-        return;
+  template < int nDim, int nNodes >
+  void DisplacementFiniteElement< nDim, nNodes >::computeTrial( const double* QTotal,
+                                                                const double* dQ,
+                                                                double*       Pe,
+                                                                double*       Ke,
+                                                                const double* time,
+                                                                double        dT,
+                                                                double&       pNewDT )
+  {
+    // the buffer is moved aside, as computeYourself discards pending trials
+    trialStateVars.assign( elementStateVars, elementStateVars + nElementStateVars );
+    std::vector< double >      committedStateVars                  = std::move( trialStateVars );
+    const StateChangeTracker   committedStateChangeSinceCheckpoint = stateChangeSinceCheckpoint;
+    const IntegratedQuantities committedIntegratedQuantities       = integratedQuantities;
+
+    try {
+      computeYourself( QTotal, dQ, Pe, Ke, time, dT, pNewDT );
+    }
+    catch ( ... ) {
+      // e.g., a material failing for a large trial increment; the committed state must survive
+      std::copy( committedStateVars.begin(), committedStateVars.end(), elementStateVars );
+      stateChangeSinceCheckpoint = committedStateChangeSinceCheckpoint;
+      integratedQuantities       = committedIntegratedQuantities;
+      throw;
+    }
+
+    trialStateVars = std::move( committedStateVars );
+
+    // the trial state goes to the scratch buffer, and the committed state is restored
+    std::swap_ranges( trialStateVars.begin(), trialStateVars.end(), elementStateVars );
+    trialStateChangeSinceCheckpoint = stateChangeSinceCheckpoint;
+    stateChangeSinceCheckpoint      = committedStateChangeSinceCheckpoint;
+    trialIntegratedQuantities       = integratedQuantities;
+    integratedQuantities            = committedIntegratedQuantities;
+  }
+
+  template < int nDim, int nNodes >
+  void DisplacementFiniteElement< nDim, nNodes >::acceptTrial()
+  {
+    if ( trialStateVars.size() != static_cast< size_t >( nElementStateVars ) )
+      throw std::invalid_argument( MakeString() << __PRETTY_FUNCTION__ << ": no trial state available" );
+
+    std::copy( trialStateVars.begin(), trialStateVars.end(), elementStateVars );
+    stateChangeSinceCheckpoint = trialStateChangeSinceCheckpoint;
+    integratedQuantities       = trialIntegratedQuantities;
+
+    trialStateVars.clear();
+  }
+
+  template < int nDim, int nNodes >
+  void DisplacementFiniteElement< nDim, nNodes >::deactivate()
+  {
+    if ( active )
+      stateChangeSinceCheckpoint.markChanged();
+
+    trialStateVars.clear();
+    active               = false;
+    integratedQuantities = IntegratedQuantities();
+  }
+
+  template < int nDim, int nNodes >
+  void DisplacementFiniteElement< nDim, nNodes >::activate()
+  {
+    if ( active || eroded )
+      return;
+
+    for ( QuadraturePoint& qp : qps ) {
+      qp.managedStateVars->stress.setZero();
+      qp.managedStateVars->strain.setZero();
+      qp.managedStateVars->materialStateVars.setZero();
+      if ( qp.material )
+        qp.material->initializeYourself();
+    }
+
+    stateChangeSinceCheckpoint.markChanged();
+    trialStateVars.clear();
+    active = true;
+  }
+
+  template < int nDim, int nNodes >
+  void DisplacementFiniteElement< nDim, nNodes >::restoreActivationState( bool isActive, bool isEroded )
+  {
+    if ( isActive && isEroded )
+      throw std::invalid_argument( MakeString() << __PRETTY_FUNCTION__ << ": element " << elLabel
+                                                << " cannot be both active and eroded" );
+
+    active = isActive;
+    eroded = isEroded;
+    if ( !active )
+      integratedQuantities = IntegratedQuantities();
+  }
+
+  template < int nDim, int nNodes >
+  void DisplacementFiniteElement< nDim, nNodes >::setErosionCriterion( const std::string& stateName, double threshold )
+  {
+    if ( !elementStateVars )
+      throw std::invalid_argument( MakeString() << __PRETTY_FUNCTION__ << ": element " << elLabel
+                                                << " has no state vars assigned" );
+
+    const StateView view = getStateView( stateName, 0 );
+    if ( view.stateSize < 1 )
+      throw std::invalid_argument( MakeString() << __PRETTY_FUNCTION__ << ": state " << stateName
+                                                << " of element " << elLabel << " is empty" );
+
+    erosionStateOffset = view.stateLocation - elementStateVars;
+    erosionThreshold   = threshold;
+  }
+
+  template < int nDim, int nNodes >
+  bool DisplacementFiniteElement< nDim, nNodes >::updateErosion()
+  {
+    if ( eroded || !active || erosionStateOffset < 0 )
+      return eroded;
+
+    const int nQpStateVars = nElementStateVars / qps.size();
+
+    // an element without active quadrature points, e.g., in a hyper-reduced model, has no failed ones either
+    int nFailedQps = 0;
+    for ( size_t i = 0; i < qps.size(); i++ ) {
+      if ( !qps[i].isActive )
+        continue;
+      if ( elementStateVars[i * nQpStateVars + erosionStateOffset] < erosionThreshold )
+        return false;
+      nFailedQps++;
+    }
+
+    if ( nFailedQps == 0 )
+      return false;
+
+    deactivate();
+    eroded = true;
+
+    return true;
+  }
+
+  template < int nDim, int nNodes >
+  void DisplacementFiniteElement< nDim, nNodes >::computeLinearResiduals( const double* dQ_,
+                                                                          double*       Pe_,
+                                                                          int           nRightHandSides,
+                                                                          const double* time,
+                                                                          double        dT )
+  {
+    if ( !active )
+      return;
+
+    Map< const Matrix< double, sizeLoadVector, Dynamic > > dQ( dQ_, sizeLoadVector, nRightHandSides );
+    Map< Matrix< double, sizeLoadVector, Dynamic > >       Pe( Pe_, sizeLoadVector, nRightHandSides );
+
+    using VoigtMatrix = Matrix< double, ParentGeometryElement::voigtSize, Dynamic >;
+
+    Voigt       S;
+    CSized      C;
+    VoigtMatrix SK( ParentGeometryElement::voigtSize, nRightHandSides );
+
+    for ( QuadraturePoint& qp : qps ) {
+      if ( !qp.isActive )
+        continue;
+
+      computeCommittedMaterialResponse( qp, S, C, time, dT );
+
+      const auto& B = qp.B.template cast< double >();
+
+      SK.noalias() = C * ( B * dQ );
+      SK.colwise() += S;
+
+      Pe.noalias() -= B.transpose() * SK * qp.J0xW;
+    }
+  }
+
+  template < int nDim, int nNodes >
+  void DisplacementFiniteElement< nDim, nNodes >::computeCommittedResponse( double*       Pe_,
+                                                                            double*       Ke_,
+                                                                            const double* time,
+                                                                            double        dT )
+  {
+    if ( !active )
+      return;
+
+    Map< KeSizedMatrix > Ke( Ke_ );
+    Map< RhsSized >      Pe( Pe_ );
+
+    Voigt  S;
+    CSized C;
+
+    for ( QuadraturePoint& qp : qps ) {
+      if ( !qp.isActive )
+        continue;
+
+      computeCommittedMaterialResponse( qp, S, C, time, dT );
+
+      const auto& B = qp.B.template cast< double >();
 
       Ke += B.transpose() * C * B * qp.J0xW;
       Pe -= B.transpose() * S * qp.J0xW;
     }
   }
 
+  template < int nDim, int nNodes >
+  void DisplacementFiniteElement< nDim, nNodes >::computeCommittedMaterialResponse( QuadraturePoint& qp,
+                                                                                    Voigt&           S,
+                                                                                    CSized&          C,
+                                                                                    const double*    time,
+                                                                                    double           dT )
+  {
+    const Voigt zeroIncrement = Voigt::Zero();
+    double      pNewDT        = 1.0;
+
+    // the material may alter its state even for a zero increment, hence the committed state is restored
+    auto& materialStateVars = qp.managedStateVars->materialStateVars;
+    committedMaterialStateVars.assign( materialStateVars.data(), materialStateVars.data() + materialStateVars.size() );
+    const Vector6d committedStress = qp.managedStateVars->stress;
+
+    computeMaterialResponse( qp, zeroIncrement, S, C, time, dT, pNewDT );
+
+    std::copy( committedMaterialStateVars.begin(), committedMaterialStateVars.end(), materialStateVars.data() );
+    qp.managedStateVars->stress = committedStress;
+
+    // a rate dependent material relaxes within dT even for a zero increment, hence only C is taken from the material
+    S = ContinuumMechanics::VoigtNotation::reduce3DVoigt< ParentGeometryElement::voigtSize >( committedStress );
+  }
+
   template < int nDim, int nNodes >
   void DisplacementFiniteElement< nDim, nNodes >::setInitialConditions( StateTypes state, const double* values )
   {
     switch ( state ) {
     case MarmotElement::MarmotMaterialInitialization: {
       for ( QuadraturePoint& qp : qps ) {
-        qp.material->initializeYourself();
+        if ( qp.material )
+          qp.material->initializeYourself();
       }
       break;
     }
     case MarmotElement::GeostaticStress: {
-      if ( nDim >= 2 )
-        for ( QuadraturePoint& qp : qps ) {
-          XiSized coordAtGauss = this->NB( this->N( qp.xi ) ) * this->coordinates;
-
-          const double sigY1 = values[0];
-          const double sigY2 = values[2];
-          const double y1    = values[1];
-          const double y2    = values[3];
-
-          using namespace Math;
-          qp.managedStateVars->stress( 1 ) = linearInterpolation( coordAtGauss[1], y1, y2, sigY1, sigY2 ); // sigma_y
-          qp.managedStateVars->stress( 0 ) = values[4] * qp.managedStateVars->stress( 1 );                 // sigma_x
-          qp.managedStateVars->stress( 2 ) = values[5] * qp.managedStateVars->stress( 1 );
-        }
+      const GeostaticStressLayer layer{ values[0], values[1], values[2], values[3], values[4], values[5] };
+      setGeostaticStress( &layer, 1 );
       break;
     }
     case MarmotElement::MarmotMaterialStateVars: {
@@ -445,6 +1375,40 @@ namespace Marmot::Elements {
     }
   }
 
+  template < int nDim, int nNodes >
+  void DisplacementFiniteElement< nDim, nNodes >::setGeostaticStress( const GeostaticStressLayer* layers, int nLayers )
+  {
+    if ( nLayers < 1 )
+      throw std::invalid_argument( MakeString() << __PRETTY_FUNCTION__ << ": at least one layer is required" );
+
+    if constexpr ( nDim >= 2 )
+      for ( size_t iQp = 0; iQp < qps.size(); iQp++ ) {
+        QuadraturePoint& qp = qps[iQp];
+        const double     y  = qpsCold[iQp].coordinates[1];
+
+        const GeostaticStressLayer* layer           = &layers[0];
+        double                      distanceToLayer = std::numeric_limits< double >::infinity();
+        for ( int i = 0; i < nLayers && distanceToLayer > 0; i++ ) {
+          const double distance = std::max( { 0.0,
+                                               std::min( layers[i].y1, layers[i].y2 ) - y,
+                                               y - std::max( layers[i].y1, layers[i].y2 ) } );
+          if ( distance < distanceToLayer ) {
+            layer           = &layers[i];
+            distanceToLayer = distance;
+          }
+        }
+
+        using namespace Math;
+        const double sigmaY = linearInterpolation( y, layer->y1, layer->y2, layer->sigmaY1, layer->sigmaY2 );
+
+        qp.managedStateVars->stress( 0 ) = layer->K0x * sigmaY; // sigma_x
+        qp.managedStateVars->stress( 1 ) = sigmaY;              // sigma_y
+        qp.managedStateVars->stress( 2 ) = layer->K0z * sigmaY;
+      }
+
+    stateChangeSinceCheckpoint.markChanged();
+  }
+
   template < int nDim, int nNodes >
   void DisplacementFiniteElement< nDim, nNodes >::computeDistributedLoad( MarmotElement::DistributedLoadTypes loadType,
                                                                           double*                             P,
@@ -455,6 +1419,9 @@ namespace Marmot::Elements {
                                                                           const double* time,
                                                                           double        dT )
   {
+    if ( !active )
+      return;
+
     Map< RhsSized > fU( P );
 
     switch ( loadType ) {
@@ -500,21 +1467,22 @@ namespace Marmot::Elements {
                                                                     const double* time,
                                                                     double        dT )
   {
+    if ( !active )
+      return;
+
     Map< RhsSized >                              Pe( P_ );
     const Map< const Matrix< double, nDim, 1 > > f( load );
 
-    for ( const auto& qp : qps )
-      Pe += this->NB( this->N( qp.xi ) ).transpose() * f * qp.J0xW;
+    for ( size_t i = 0; i < qps.size(); i++ )
+      if ( qps[i].isActive )
+        Pe += this->NB( this->N( qpsCold[i].xi ) ).transpose() * f * qps[i].J0xW;
   }
 
   template < int nDim, int nNodes >
   std::vector< double > DisplacementFiniteElement< nDim, nNodes >::getCoordinatesAtCenter()
   {
     std::vector< double > coords( nDim );
-
-    Eigen::Map< XiSized > coordsMap( &coords[0] );
-    const auto            centerXi = XiSized::Zero();
-    coordsMap                      = this->NB( this->N( centerXi ) ) * this->coordinates;
+    getCoordinatesAtCenter( coords.data() );
     return coords;
   }
 
@@ -522,16 +1490,119 @@ namespace Marmot::Elements {
   std::vector< std::vector< double > > DisplacementFiniteElement< nDim, nNodes >::getCoordinatesAtQuadraturePoints()
   {
     std::vector< std::vector< double > > listedCoords;
+    listedCoords.reserve( qps.size() );
 
-    std::vector< double > coords( nDim );
-    Eigen::Map< XiSized > coordsMap( &coords[0] );
+    for ( const auto& qpCold : qpsCold )
+      listedCoords.emplace_back( qpCold.coordinates.data(), qpCold.coordinates.data() + nDim );
+
+    return listedCoords;
+  }
+
+  template < int nDim, int nNodes >
+  void DisplacementFiniteElement< nDim, nNodes >::getCoordinatesAtCenter( double* coordinates )
+  {
+    Map< XiSized > coordsMap( coordinates );
+    coordsMap = centerCoordinates;
+  }
 
-    for ( const auto& qp : qps ) {
-      coordsMap = this->NB( this->N( qp.xi ) ) * this->coordinates;
-      listedCoords.push_back( coords );
+  template < int nDim, int nNodes >
+  void DisplacementFiniteElement< nDim, nNodes >::getCoordinatesAtQuadraturePoints( double* coordinates )
+  {
+    Map< Matrix< double, nDim, Dynamic > > coordsMap( coordinates, nDim, qps.size() );
+    for ( size_t i = 0; i < qps.size(); i++ )
+      coordsMap.col( i ) = qpsCold[i].coordinates;
+  }
+
+  template < int nDim, int nNodes >
+  void DisplacementFiniteElement< nDim, nNodes >::computeNodalStresses( double* nodalStresses )
+  {
+    Map< Matrix< double, 6, nNodes > > nodalStressesMap( nodalStresses );
+
+    const bool isReduced = std::any_of( qps.begin(), qps.end(), []( const auto& qp ) { return !qp.isActive; } );
+
+    if ( isReduced ) {
+      // stresses of inactive quadrature points are stale, so only a constant field is recovered
+      Vector6d meanStress = Vector6d::Zero();
+      double   volume     = 0.0;
+      for ( const auto& qp : qps ) {
+        if ( !qp.isActive )
+          continue;
+        meanStress += qp.managedStateVars->stress * qp.J0xW;
+        volume += qp.J0xW;
+      }
+      if ( volume > 0 )
+        meanStress /= volume;
+
+      nodalStressesMap = meanStress.replicate< 1, nNodes >();
+      return;
     }
 
-    return listedCoords;
+    Matrix< double, 6, Dynamic > qpStresses( 6, qps.size() );
+    for ( size_t i = 0; i < qps.size(); i++ )
+      qpStresses.col( i ) = qps[i].managedStateVars->stress;
+
+    nodalStressesMap = qpStresses * qpToNodeExtrapolation->transpose();
+  }
+
+  template < int nDim, int nNodes >
+  StressErrorIndicator DisplacementFiniteElement< nDim, nNodes >::computeStressErrorIndicator(
+    const double* recoveredNodalStresses )
+  {
+    const Map< const Matrix< double, 6, nNodes > > nodalStresses( recoveredNodalStresses );
+
+    // tensor norm of a stress vector in Voigt notation
+    const auto normSquared = []( const Vector6d& stress ) {
+      return stress.head< 3 >().squaredNorm() + 2 * stress.tail< 3 >().squaredNorm();
+    };
+
+    StressErrorIndicator indicator{ 0.0, 0.0 };
+    for ( size_t i = 0; i < qps.size(); i++ ) {
+      if ( !qps[i].isActive )
+        continue;
+
+      const Vector6d stress          = qps[i].managedStateVars->stress;
+      const Vector6d recoveredStress = nodalStresses * this->N( qpsCold[i].xi ).transpose();
+
+      indicator.errorSquared += normSquared( recoveredStress - stress ) * qps[i].J0xW;
+      indicator.stressSquared += normSquared( stress ) * qps[i].J0xW;
+    }
+
+    return indicator;
+  }
+
+  template < int nDim, int nNodes >
+  void DisplacementFiniteElement< nDim, nNodes >::setQuadraturePointMask( const bool* isActive, const double* J0xW )
+  {
+    for ( size_t i = 0; i < qps.size(); i++ ) {
+      qps[i].isActive = isActive[i];
+      qps[i].J0xW     = J0xW && isActive[i] ? J0xW[i] : qpsCold[i].referenceJ0xW;
+    }
+  }
+
+  template < int nDim, int nNodes >
+  void DisplacementFiniteElement< nDim, nNodes >::resetQuadraturePointMask()
+  {
+    for ( size_t i = 0; i < qps.size(); i++ ) {
+      qps[i].isActive = true;
+      qps[i].J0xW     = qpsCold[i].referenceJ0xW;
+    }
+  }
+
+  template < int nDim, int nNodes >
+  void DisplacementFiniteElement< nDim, nNodes >::computeQuadraturePointInternalForces( double* qpForces )
+  {
+    using namespace ContinuumMechanics::VoigtNotation;
+
+    Map< Matrix< double, sizeLoadVector, Dynamic > > qpForcesMap( qpForces, sizeLoadVector, qps.size() );
+
+    for ( size_t i = 0; i < qps.size(); i++ ) {
+      if ( !qps[i].isActive ) {
+        qpForcesMap.col( i ).setZero();
+        continue;
+      }
+      const Voigt S        = reduce3DVoigt< ParentGeometryElement::voigtSize >( qps[i].managedStateVars->stress );
+      qpForcesMap.col( i ) = qps[i].B.template cast< double >().transpose() * S * qps[i].J0xW;
+    }
   }
 
   template < int nDim, int nNodes >
@@ -539,4 +1610,45 @@ namespace Marmot::Elements {
   {
     return qps.size();
   }
+
+  template < int nDim, int nNodes >
+  void DisplacementFiniteElement< nDim, nNodes >::exportGeometry( double* geometry )
+  {
+    for ( size_t i = 0; i < qps.size(); i++ ) {
+      geometry[0] = qpsCold[i].detJ;
+      geometry[1] = qpsCold[i].referenceJ0xW;
+      geometry[2] = qps[i].J0xW;
+      geometry[3] = qps[i].isActive ? 1.0 : 0.0;
+      Map< BSized >( geometry + 4 ) = qps[i].B.template cast< double >();
+      geometry += nGeometryEntriesQuadraturePoint;
+    }
+  }
+
+  template < int nDim, int nNodes >
+  void DisplacementFiniteElement< nDim, nNodes >::importGeometry( const double* geometry )
+  {
+    for ( size_t i = 0; i < qps.size(); i++ ) {
+      qpsCold[i].detJ          = geometry[0];
+      qpsCold[i].referenceJ0xW = geometry[1];
+      qps[i].J0xW              = geometry[2];
+      qps[i].isActive          = geometry[3] != 0.0;
+      qps[i].B                 = Map< const BSized >( geometry + 4 ).template cast< GeometryScalar >();
+      geometry += nGeometryEntriesQuadraturePoint;
+    }
+
+    qpToNodeExtrapolation = &getQuadraturePointToNodeExtrapolation();
+  }
+
+  template < int nDim, int nNodes >
+  void DisplacementFiniteElement< nDim, nNodes >::relocateQuadraturePoints( std::pmr::memory_resource* memoryResource )
+  {
+    std::pmr::vector< QuadraturePoint > relocatedQps( memoryResource );
+    relocatedQps.reserve( qps.size() );
+    for ( QuadraturePoint& qp : qps )
+      relocatedQps.push_back( std::move( qp ) );
+
+    // the move assignment of a pmr vector keeps its memory resource, hence the vector is reconstructed in place
+    qps.~vector();
+    new ( &qps ) std::pmr::vector< QuadraturePoint >( std::move( relocatedQps ) );
+  }
 } // namespace Marmot::Elements
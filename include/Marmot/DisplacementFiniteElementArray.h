@@ -0,0 +1,122 @@
+/* ---------------------------------------------------------------------
+ *                                       _
+ *  _ __ ___   __ _ _ __ _ __ ___   ___ | |_
+ * | '_ ` _ \ / _` | '__| '_ ` _ \ / _ \| __|
+ * | | | | | | (_| | |  | | | | | | (_) | |_
+ * |_| |_| |_|\__,_|_|  |_| |_| |_|\___/ \__|
+ *
+ * Unit of Strength of Materials and Structural Analysis
+ * University of Innsbruck,
+ * 2020 - today
+ *
+ * festigkeitslehre@uibk.ac.at
+ *
+ * Matthias Neuner matthias.neuner@uibk.ac.at
+ * Magdalena Schreter magdalena.schreter@uibk.ac.at
+ *
+ * This file is part of the MAteRialMOdellingToolbox (marmot).
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * The full text of the license can be found in the file LICENSE.md at
+ * the top level directory of marmot.
+ * ---------------------------------------------------------------------
+ */
+#pragma once
+#include "Marmot/DisplacementFiniteElement.h"
+#include <cstddef>
+#include <memory_resource>
+#include <new>
+#include <vector>
+
+namespace Marmot::Elements {
+
+  /* Contiguous storage of nElements elements of a single type, which are cloned from a prototype,
+   * e.g., an element created by the MarmotElementFactory for the respective element code.
+   * Only the reference data (section, formulation and quadrature rule) is taken from the prototype,
+   * such that the quadrature rule is not set up again for each element;
+   * the elements are subsequently initialized as usual (properties, coordinates, state vars).
+   * The elements and their quadrature point data are allocated from the (optional) memory resource,
+   * which must outlive the array.
+   * The elements are never relocated, hence pointers to the elements remain valid for the lifetime of the array.
+   * */
+  template < int nDim, int nNodes >
+  class DisplacementFiniteElementArray {
+
+  public:
+    using Element = DisplacementFiniteElement< nDim, nNodes >;
+
+    DisplacementFiniteElementArray( const Element&             prototype,
+                                    const int*                 elementLabels,
+                                    size_t                     nElements,
+                                    std::pmr::memory_resource* memoryResource = nullptr );
+
+    ~DisplacementFiniteElementArray();
+
+    DisplacementFiniteElementArray( const DisplacementFiniteElementArray& )            = delete;
+    DisplacementFiniteElementArray& operator=( const DisplacementFiniteElementArray& ) = delete;
+
+    size_t size() const { return nElements; }
+
+    Element&       operator[]( size_t i ) { return elements[i]; }
+    const Element& operator[]( size_t i ) const { return elements[i]; }
+
+    Element*       begin() { return elements; }
+    Element*       end() { return elements + nElements; }
+    const Element* begin() const { return elements; }
+    const Element* end() const { return elements + nElements; }
+
+    /* e.g., for the construction of a DisplacementFiniteElementBlock */
+    std::vector< Element* > getElementPointers()
+    {
+      std::vector< Element* > pointers( nElements );
+      for ( size_t i = 0; i < nElements; i++ )
+        pointers[i] = elements + i;
+      return pointers;
+    }
+
+  private:
+    std::pmr::memory_resource* memoryResource;
+    Element*                   elements;
+    size_t                     nElements;
+  };
+
+  template < int nDim, int nNodes >
+  DisplacementFiniteElementArray< nDim, nNodes >::DisplacementFiniteElementArray(
+    const Element&             prototype,
+    const int*                 elementLabels,
+    size_t                     nElements,
+    std::pmr::memory_resource* memoryResource )
+    : memoryResource( memoryResource ? memoryResource : std::pmr::get_default_resource() ),
+      elements( nullptr ),
+      nElements( nElements )
+  {
+    elements = static_cast< Element* >(
+      this->memoryResource->allocate( nElements * sizeof( Element ), alignof( Element ) ) );
+
+    size_t i = 0;
+    try {
+      for ( ; i < nElements; i++ )
+        new ( elements + i ) Element( elementLabels[i], prototype, this->memoryResource );
+    }
+    catch ( ... ) {
+      for ( size_t j = 0; j < i; j++ )
+        elements[j].~Element();
+      this->memoryResource->deallocate( elements, nElements * sizeof( Element ), alignof( Element ) );
+      throw;
+    }
+  }
+
+  template < int nDim, int nNodes >
+  DisplacementFiniteElementArray< nDim, nNodes >::~DisplacementFiniteElementArray()
+  {
+    for ( size_t i = 0; i < nElements; i++ )
+      elements[i].~Element();
+
+    memoryResource->deallocate( elements, nElements * sizeof( Element ), alignof( Element ) );
+  }
+
+} // namespace Marmot::Elements
@@ -0,0 +1,652 @@
+/* ---------------------------------------------------------------------
+ *                                       _
+ *  _ __ ___   __ _ _ __ _ __ ___   ___ | |_
+ * | '_ ` _ \ / _` | '__| '_ ` _ \ / _ \| __|
+ * | | | | | | (_| | |  | | | | | | (_) | |_
+ * |_| |_| |_|\__,_|_|  |_| |_| |_|\___/ \__|
+ *
+ * Unit of Strength of Materials and Structural Analysis
+ * University of Innsbruck,
+ * 2020 - today
+ *
+ * festigkeitslehre@uibk.ac.at
+ *
+ * Matthias Neuner matthias.neuner@uibk.ac.at
+ * Magdalena Schreter magdalena.schreter@uibk.ac.at
+ *
+ * This file is part of the MAteRialMOdellingToolbox (marmot).
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * The full text of the license can be found in the file LICENSE.md at
+ * the top level directory of marmot.
+ * ---------------------------------------------------------------------
+ */
+#pragma once
+#include "Marmot/DisplacementFiniteElement.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <memory_resource>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Marmot::Elements {
+
+  /* Binary file of initial quadrature point states, e.g., mapped results of a previous analysis:
+   *  - InitialStateFileHeader
+   *  - nRecords records, each consisting of the element label (int32), the quadrature point index (int32)
+   *    and nComponents values (double), in arbitrary order
+   * */
+  struct InitialStateFileHeader {
+    char     magic[8]; // "MARMOTIS"
+    uint32_t version;  // 1
+    uint32_t nComponents;
+    uint64_t nRecords;
+  };
+
+  namespace SpaceFillingCurve {
+
+    enum Type {
+      Morton,
+      Hilbert,
+    };
+
+    /* position of a point along a space filling curve through the unit cube [0, 1]^nDim,
+     * resolved with 63 / nDim bits per coordinate, but at most 52 bits,
+     * so that the scaled coordinates are exact in double precision and do not exceed the axis range;
+     * the Hilbert index is computed by the transposition algorithm of Skilling (2004) */
+    template < int nDim >
+    uint64_t computeKey( const double* normalizedCoordinates, Type type )
+    {
+      constexpr int      nBits   = std::min( 63 / nDim, 52 );
+      constexpr uint64_t maxAxis = ( uint64_t( 1 ) << nBits ) - 1;
+
+      uint64_t X[nDim];
+      for ( int i = 0; i < nDim; i++ )
+        X[i] = static_cast< uint64_t >( std::clamp( normalizedCoordinates[i], 0.0, 1.0 ) * maxAxis );
+
+      if ( type == Hilbert ) {
+        const uint64_t M = uint64_t( 1 ) << ( nBits - 1 );
+
+        // inverse undo
+        for ( uint64_t Q = M; Q > 1; Q >>= 1 ) {
+          const uint64_t P = Q - 1;
+          for ( int i = 0; i < nDim; i++ ) {
+            if ( X[i] & Q )
+              X[0] ^= P;
+
+            else {
+              const uint64_t t = ( X[0] ^ X[i] ) & P;
+              X[0] ^= t;
+              X[i] ^= t;
+            }
+          }
+        }
+
+        // gray encode
+        for ( int i = 1; i < nDim; i++ )
+          X[i] ^= X[i - 1];
+
+        uint64_t t = 0;
+        for ( uint64_t Q = M; Q > 1; Q >>= 1 )
+          if ( X[nDim - 1] & Q )
+            t ^= Q - 1;
+
+        for ( int i = 0; i < nDim; i++ )
+          X[i] ^= t;
+      }
+
+      // interleave the bits of all axes, starting with the most significant ones
+      uint64_t key = 0;
+      for ( int bit = nBits - 1; bit >= 0; bit-- )
+        for ( int i = 0; i < nDim; i++ )
+          key = ( key << 1 ) | ( ( X[i] >> bit ) & 1 );
+
+      return key;
+    }
+  } // namespace SpaceFillingCurve
+
+  /* A block of DisplacementFiniteElements of the same type,
+   * providing bulk operations over the whole block or over ranges [begin, end) of it.
+   * The elements are not owned by the block.
+   * Bulk operations are parallelized with OpenMP, if enabled.
+   * If all elements share a known material type Material, the material update in computeYourself
+   * is dispatched statically (cf. MaterialDispatch), and it may be inlined into the element loop;
+   * otherwise, the default MarmotMaterialHypoElastic retains the virtual dispatch.
+   * */
+  template < int nDim, int nNodes, class Material = MarmotMaterialHypoElastic >
+  class DisplacementFiniteElementBlock {
+
+  public:
+    using Element = DisplacementFiniteElement< nDim, nNodes >;
+
+    std::vector< Element* > elements;
+
+    /* indices of the active elements, which are considered by computeYourself */
+    std::vector< size_t > activeElements;
+
+    /* if prefetchDistance is not 0, computeYourself prefetches the geometry and the state vars of the element
+     * prefetchDistance elements ahead of the currently evaluated one, at most maxPrefetchBytes per element,
+     * so that large elements (e.g., C3D20) do not flood the cache;
+     * prefetching is opt-in, as no measurement has yet shown a gain which justifies enabling it by default;
+     * getSuggestedPrefetchDistance is a starting point for tuning it on the machine and the model at hand */
+    static constexpr size_t maxPrefetchBytes    = 4096;
+    static constexpr size_t prefetchWindowBytes = 16384;
+
+    size_t prefetchDistance = 0;
+
+    /* prefetchWindowBytes over the estimated prefetched bytes per element (with nNodes quadrature points);
+     * an unmeasured heuristic */
+    static constexpr size_t getSuggestedPrefetchDistance()
+    {
+      constexpr size_t bytesPerElement = std::min( maxPrefetchBytes,
+                                                   nNodes * sizeof( typename Element::QuadraturePoint ) );
+      return std::clamp( prefetchWindowBytes / bytesPerElement, size_t( 1 ), size_t( 8 ) );
+    }
+
+    DisplacementFiniteElementBlock() = default;
+
+    explicit DisplacementFiniteElementBlock( std::vector< Element* > elements ) : elements( std::move( elements ) )
+    {
+      updateActiveElements();
+    };
+
+    void addElement( Element& element )
+    {
+      elements.push_back( &element );
+      if ( element.isActive() )
+        activeElements.push_back( elements.size() - 1 );
+    }
+
+    size_t size() const { return elements.size(); }
+
+    /* ensure that the materials of all elements are exactly of type Material,
+     * required before the first computeYourself of a block for a known material type, after the material assignment;
+     * it must be called again if elements are added or replaced, otherwise computeYourself throws */
+    void checkMaterialType();
+
+    /* rebuild the list of active elements, required if elements are (de)activated directly */
+    void updateActiveElements();
+
+    void activateElements( const std::vector< size_t >& indices );
+
+    void deactivateElements( const std::vector< size_t >& indices );
+
+    /* check the erosion criterion of all active elements, e.g., after a converged increment,
+     * and remove the eroded elements from the active elements; returns the number of newly eroded elements;
+     * the erosion state is resolved by setErosionCriterion, hence nothing is thrown inside the parallel loop */
+    size_t updateErosion();
+
+    /* total number of state vars of all elements */
+    size_t getNumberOfStateVars() const;
+
+    /* copy the state vars of all elements to stateVars (contiguous, in block order), and bind the elements to it,
+     * e.g., to a buffer from a Memory::HugePageArena; it must not overlap the current state vars of the elements */
+    void relocateStateVars( double* stateVars );
+
+    /* sort the elements along a space filling curve through their centers, for locality in bulk operations;
+     * if stateVars is not a nullptr, the state vars are relocated to it in the new order (cf. relocateStateVars);
+     * if geometryResource is not a nullptr, the hot quadrature point data (including B) of the elements is
+     * reallocated from it in the new order, e.g., from a fresh Memory::HugePageArena, which then holds the geometry
+     * contiguously in sweep order (cf. DisplacementFiniteElement::relocateQuadraturePoints);
+     * otherwise, the geometry remains in allocation order; the element objects themselves are never moved;
+     * returns the permutation (the former index of each element), e.g., for reordering connectivity and dof arrays */
+    std::vector< size_t > reorderAlongSpaceFillingCurve( SpaceFillingCurve::Type    type,
+                                                         double*                    stateVars,
+                                                         std::pmr::memory_resource* geometryResource = nullptr );
+
+    /* computeYourself of all active elements, with element contiguous arrays in block order:
+     * QTotal, dQ and Pe (nElements x sizeLoadVector), and Ke (nElements x sizeLoadVector^2);
+     * the entries of inactive elements are not touched;
+     * for a known material type, the elements must have been validated by checkMaterialType;
+     * returns the smallest pNewDT of all elements */
+    double computeYourself( const double* QTotal,
+                            const double* dQ,
+                            double*       Pe,
+                            double*       Ke,
+                            const double* time,
+                            double        dT );
+
+    void setGeostaticStress( const GeostaticStressLayer* layers, int nLayers )
+    {
+      setGeostaticStress( layers, nLayers, 0, elements.size() );
+    }
+
+    void setGeostaticStress( const GeostaticStressLayer* layers, int nLayers, size_t begin, size_t end );
+
+    /* stream an initial state file into the state vars of the quadrature point state stateName;
+     * records of elements not contained in the block are skipped,
+     * and the number of applied records is returned;
+     * elements which received a record are marked as changed for incremental checkpoints */
+    size_t readInitialState( const std::string& fileName, const std::string& stateName );
+
+    /* nodal averaged stresses (nGlobalNodes x 6) from the extrapolated quadrature point stresses;
+     * connectivity holds the global node indices of each element (nElements x nNodes) in block order */
+    void computeNodalStresses( const int* connectivity, int nGlobalNodes, double* nodalStresses );
+
+    /* Zienkiewicz-Zhu error estimation based on recovered nodal stresses (nGlobalNodes x 6),
+     * e.g., from computeNodalStresses;
+     * writes the element error indicators (L2 norm of the stress error) to errorIndicators (nElements)
+     * and returns the relative global error;
+     * as the extrapolation of computeNodalStresses reproduces constant fields for all element types
+     * (including reduced integrated serendipity elements), the indicators vanish for a uniform stress state */
+    double computeStressErrorIndicators( const int*    connectivity,
+                                         const double* nodalStresses,
+                                         double*       errorIndicators );
+
+    /* sum of the integrated quantities of all elements from their most recent computeYourself */
+    IntegratedQuantities computeIntegratedQuantities();
+
+  private:
+    /* the elements as of the most recent successful checkMaterialType */
+    std::vector< Element* > materialTypeCheckedElements;
+
+    static void prefetch( const void* data, size_t nBytes, bool isWritten );
+
+    static void prefetchElement( const Element& element );
+  };
+
+  template < int nDim, int nNodes, class Material >
+  void DisplacementFiniteElementBlock< nDim, nNodes, Material >::updateActiveElements()
+  {
+    activeElements.clear();
+    for ( size_t i = 0; i < elements.size(); i++ )
+      if ( elements[i]->isActive() )
+        activeElements.push_back( i );
+  }
+
+  template < int nDim, int nNodes, class Material >
+  void DisplacementFiniteElementBlock< nDim, nNodes, Material >::activateElements(
+    const std::vector< size_t >& indices )
+  {
+#pragma omp parallel for schedule( static )
+    for ( size_t i = 0; i < indices.size(); i++ )
+      elements[indices[i]]->activate();
+
+    updateActiveElements();
+  }
+
+  template < int nDim, int nNodes, class Material >
+  void DisplacementFiniteElementBlock< nDim, nNodes, Material >::deactivateElements(
+    const std::vector< size_t >& indices )
+  {
+    for ( size_t i : indices )
+      elements[i]->deactivate();
+
+    updateActiveElements();
+  }
+
+  template < int nDim, int nNodes, class Material >
+  size_t DisplacementFiniteElementBlock< nDim, nNodes, Material >::updateErosion()
+  {
+    std::vector< char > isEroded( activeElements.size() );
+
+#pragma omp parallel for schedule( static )
+    for ( size_t i = 0; i < activeElements.size(); i++ )
+      isEroded[i] = elements[activeElements[i]]->updateErosion();
+
+    size_t nActive = 0;
+    for ( size_t i = 0; i < activeElements.size(); i++ )
+      if ( !isEroded[i] )
+        activeElements[nActive++] = activeElements[i];
+
+    const size_t nEroded = activeElements.size() - nActive;
+    activeElements.resize( nActive );
+
+    return nEroded;
+  }
+
+  template < int nDim, int nNodes, class Material >
+  void DisplacementFiniteElementBlock< nDim, nNodes, Material >::checkMaterialType()
+  {
+    materialTypeCheckedElements.clear();
+
+    for ( const Element* element : elements )
+      if ( !element->template hasMaterialType< Material >() )
+        throw std::invalid_argument( MakeString() << __PRETTY_FUNCTION__ << ": element " << element->elLabel
+                                                  << " has a material of a different type than the block" );
+
+    materialTypeCheckedElements = elements;
+  }
+
+  template < int nDim, int nNodes, class Material >
+  size_t DisplacementFiniteElementBlock< nDim, nNodes, Material >::getNumberOfStateVars() const
+  {
+    size_t nStateVars = 0;
+    for ( const Element* element : elements )
+      nStateVars += element->nElementStateVars;
+
+    return nStateVars;
+  }
+
+  template < int nDim, int nNodes, class Material >
+  void DisplacementFiniteElementBlock< nDim, nNodes, Material >::relocateStateVars( double* stateVars )
+  {
+    std::vector< size_t > offsets( elements.size() + 1, 0 );
+    for ( size_t i = 0; i < elements.size(); i++ )
+      offsets[i + 1] = offsets[i] + elements[i]->nElementStateVars;
+
+#pragma omp parallel for schedule( static )
+    for ( size_t i = 0; i < elements.size(); i++ ) {
+      Element& element = *elements[i];
+      std::copy_n( element.elementStateVars, element.nElementStateVars, stateVars + offsets[i] );
+      element.assignStateVars( stateVars + offsets[i], element.nElementStateVars );
+    }
+  }
+
+  template < int nDim, int nNodes, class Material >
+  std::vector< size_t > DisplacementFiniteElementBlock< nDim, nNodes, Material >::reorderAlongSpaceFillingCurve(
+    SpaceFillingCurve::Type    type,
+    double*                    stateVars,
+    std::pmr::memory_resource* geometryResource )
+  {
+    const size_t nElements = elements.size();
+
+    Matrix< double, nDim, Dynamic > centers( nDim, nElements );
+    for ( size_t i = 0; i < nElements; i++ )
+      elements[i]->getCoordinatesAtCenter( centers.col( i ).data() );
+
+    std::vector< size_t > permutation( nElements );
+    std::iota( permutation.begin(), permutation.end(), 0 );
+
+    if ( nElements == 0 )
+      return permutation;
+
+    const Matrix< double, nDim, 1 > lowerBound = centers.rowwise().minCoeff();
+    const Matrix< double, nDim, 1 > extent     = ( centers.rowwise().maxCoeff() - lowerBound ).cwiseMax( 1e-300 );
+
+    std::vector< uint64_t > keys( nElements );
+#pragma omp parallel for schedule( static )
+    for ( size_t i = 0; i < nElements; i++ ) {
+      const Matrix< double, nDim, 1 > normalized = ( centers.col( i ) - lowerBound ).cwiseQuotient( extent );
+      keys[i]                                    = SpaceFillingCurve::computeKey< nDim >( normalized.data(), type );
+    }
+
+    std::stable_sort( permutation.begin(), permutation.end(), [&]( size_t a, size_t b ) {
+      return keys[a] < keys[b];
+    } );
+
+    const bool isMaterialTypeChecked = materialTypeCheckedElements == elements;
+
+    std::vector< Element* > sortedElements( nElements );
+    for ( size_t i = 0; i < nElements; i++ )
+      sortedElements[i] = elements[permutation[i]];
+    elements = std::move( sortedElements );
+
+    if ( isMaterialTypeChecked )
+      materialTypeCheckedElements = elements;
+
+    if ( stateVars )
+      relocateStateVars( stateVars );
+
+    // serial, such that consecutive elements receive consecutive allocations from a monotonic resource
+    if ( geometryResource )
+      for ( Element* element : elements )
+        element->relocateQuadraturePoints( geometryResource );
+
+    updateActiveElements();
+
+    return permutation;
+  }
+
+  template < int nDim, int nNodes, class Material >
+  double DisplacementFiniteElementBlock< nDim, nNodes, Material >::computeYourself( const double* QTotal,
+                                                                                   const double* dQ,
+                                                                                   double*       Pe,
+                                                                                   double*       Ke,
+                                                                                   const double* time,
+                                                                                   double        dT )
+  {
+    constexpr int sizeLoadVector = Element::sizeLoadVector;
+    constexpr int sizeKe         = sizeLoadVector * sizeLoadVector;
+
+    if constexpr ( !MaterialDispatch< Material >::isVirtual )
+      if ( materialTypeCheckedElements != elements )
+        throw std::invalid_argument( MakeString() << __PRETTY_FUNCTION__
+                                                  << ": the material type of the elements has not been checked "
+                                                     "since the elements were changed (cf. checkMaterialType)" );
+
+    double pNewDT = std::numeric_limits< double >::max();
+
+#pragma omp parallel for schedule( static ) reduction( min : pNewDT )
+    for ( size_t i = 0; i < activeElements.size(); i++ ) {
+      const size_t e             = activeElements[i];
+      double       elementPNewDT = std::numeric_limits< double >::max();
+
+      if ( prefetchDistance > 0 && i + prefetchDistance < activeElements.size() )
+        prefetchElement( *elements[activeElements[i + prefetchDistance]] );
+
+      elements[e]->template computeYourselfWithMaterial< Material >( QTotal + e * sizeLoadVector,
+                                                                     dQ + e * sizeLoadVector,
+                                                                     Pe + e * sizeLoadVector,
+                                                                     Ke + e * sizeKe,
+                                                                     time,
+                                                                     dT,
+                                                                     elementPNewDT );
+
+      pNewDT = std::min( pNewDT, elementPNewDT );
+    }
+
+    return pNewDT;
+  }
+
+  template < int nDim, int nNodes, class Material >
+  void DisplacementFiniteElementBlock< nDim, nNodes, Material >::prefetch( const void* data,
+                                                                           size_t      nBytes,
+                                                                           bool        isWritten )
+  {
+#if defined( __GNUC__ )
+    const char* bytes = static_cast< const char* >( data );
+    for ( size_t offset = 0; offset < nBytes; offset += 64 ) {
+      if ( isWritten )
+        __builtin_prefetch( bytes + offset, 1, 3 );
+      else
+        __builtin_prefetch( bytes + offset, 0, 3 );
+    }
+#endif
+  }
+
+  template < int nDim, int nNodes, class Material >
+  void DisplacementFiniteElementBlock< nDim, nNodes, Material >::prefetchElement( const Element& element )
+  {
+    // up to half of the budget for the state vars, the remainder for the geometry
+    const size_t stateVarBytes = std::min( element.nElementStateVars * sizeof( double ), maxPrefetchBytes / 2 );
+    const size_t geometryBytes = std::min( element.qps.size() * sizeof( typename Element::QuadraturePoint ),
+                                           maxPrefetchBytes - stateVarBytes );
+
+    prefetch( element.qps.data(), geometryBytes, false );
+    prefetch( element.elementStateVars, stateVarBytes, true );
+  }
+
+  template < int nDim, int nNodes, class Material >
+  void DisplacementFiniteElementBlock< nDim, nNodes, Material >::setGeostaticStress( const GeostaticStressLayer* layers,
+                                                                                    int                         nLayers,
+                                                                                    size_t                      begin,
+                                                                                    size_t                      end )
+  {
+    // checked here, as nothing may be thrown inside the parallel loop
+    if ( nLayers < 1 )
+      throw std::invalid_argument( MakeString() << __PRETTY_FUNCTION__ << ": at least one layer is required" );
+
+#pragma omp parallel for schedule( static )
+    for ( size_t i = begin; i < end; i++ )
+      elements[i]->setGeostaticStress( layers, nLayers );
+  }
+
+  template < int nDim, int nNodes, class Material >
+  size_t DisplacementFiniteElementBlock< nDim, nNodes, Material >::readInitialState( const std::string& fileName,
+                                                                                    const std::string& stateName )
+  {
+    if ( elements.empty() )
+      return 0;
+
+    std::ifstream file( fileName, std::ios::binary );
+
+    InitialStateFileHeader header;
+    file.read( reinterpret_cast< char* >( &header ), sizeof( InitialStateFileHeader ) );
+
+    // a state cannot have more components than the state vars of a quadrature point,
+    // which bounds the chunk allocated below for corrupt or foreign files
+    size_t maxQpStateVars = 0;
+    for ( const Element* element : elements )
+      maxQpStateVars = std::max( maxQpStateVars, size_t( element->nElementStateVars / element->qps.size() ) );
+
+    if ( !file || std::memcmp( header.magic, "MARMOTIS", 8 ) != 0 || header.version != 1 ||
+         header.nComponents == 0 || header.nComponents > maxQpStateVars )
+      throw std::runtime_error( MakeString() << __PRETTY_FUNCTION__ << ": invalid initial state file " << fileName );
+
+    std::unordered_map< int, size_t > elementIndices;
+    elementIndices.reserve( elements.size() );
+    for ( size_t i = 0; i < elements.size(); i++ )
+      elementIndices[elements[i]->elLabel] = i;
+
+    // offset of the state in the state vars of a quadrature point, resolved once per element
+    std::vector< int > stateOffsets( elements.size(), -1 );
+
+    const size_t        recordSize      = 2 * sizeof( int32_t ) + header.nComponents * sizeof( double );
+    constexpr size_t    recordsPerChunk = 1 << 14;
+    std::vector< char > chunk( recordsPerChunk * recordSize );
+    size_t              nAppliedRecords = 0;
+
+    for ( uint64_t nRead = 0; nRead < header.nRecords; nRead += recordsPerChunk ) {
+      const size_t nChunkRecords = std::min< uint64_t >( recordsPerChunk, header.nRecords - nRead );
+      file.read( chunk.data(), nChunkRecords * recordSize );
+
+      if ( !file )
+        throw std::runtime_error( MakeString() << __PRETTY_FUNCTION__ << ": failed reading " << fileName );
+
+      for ( size_t i = 0; i < nChunkRecords; i++ ) {
+        const char* record = chunk.data() + i * recordSize;
+
+        int32_t elLabel, qpNumber;
+        std::memcpy( &elLabel, record, sizeof( int32_t ) );
+        std::memcpy( &qpNumber, record + sizeof( int32_t ), sizeof( int32_t ) );
+
+        const auto elementIndex = elementIndices.find( elLabel );
+        if ( elementIndex == elementIndices.end() )
+          continue;
+
+        Element&  element      = *elements[elementIndex->second];
+        const int nQpStateVars = element.nElementStateVars / element.getNumberOfQuadraturePoints();
+        int&      stateOffset  = stateOffsets[elementIndex->second];
+
+        if ( qpNumber < 0 || qpNumber >= element.getNumberOfQuadraturePoints() )
+          throw std::invalid_argument( MakeString() << __PRETTY_FUNCTION__ << ": invalid quadrature point "
+                                                    << qpNumber << " of element " << elLabel );
+
+        if ( stateOffset < 0 ) {
+          const StateView view = element.getStateView( stateName, 0 );
+          if ( view.stateSize != static_cast< int >( header.nComponents ) )
+            throw std::invalid_argument( MakeString() << __PRETTY_FUNCTION__ << ": state " << stateName
+                                                      << " of element " << elLabel
+                                                      << " does not match the initial state file" );
+          stateOffset = view.stateLocation - element.elementStateVars;
+        }
+
+        std::memcpy( element.elementStateVars + qpNumber * nQpStateVars + stateOffset,
+                     record + 2 * sizeof( int32_t ),
+                     header.nComponents * sizeof( double ) );
+        element.stateChangeSinceCheckpoint.markChanged();
+        nAppliedRecords++;
+      }
+    }
+
+    return nAppliedRecords;
+  }
+
+  template < int nDim, int nNodes, class Material >
+  void DisplacementFiniteElementBlock< nDim, nNodes, Material >::computeNodalStresses( const int* connectivity,
+                                                                                      int        nGlobalNodes,
+                                                                                      double*    nodalStresses )
+  {
+    std::vector< double > elementNodalStresses( elements.size() * nNodes * 6 );
+
+#pragma omp parallel for schedule( static )
+    for ( size_t i = 0; i < elements.size(); i++ )
+      elements[i]->computeNodalStresses( &elementNodalStresses[i * nNodes * 6] );
+
+    Map< Matrix< double, 6, Dynamic > > nodalStressesMap( nodalStresses, 6, nGlobalNodes );
+    std::vector< int >                  nodalCounts( nGlobalNodes, 0 );
+    nodalStressesMap.setZero();
+
+    for ( size_t i = 0; i < elements.size(); i++ ) {
+      if ( !elements[i]->isActive() )
+        continue;
+
+      for ( int j = 0; j < nNodes; j++ ) {
+        const int node = connectivity[i * nNodes + j];
+        nodalStressesMap.col( node ) += Map< const Vector6d >( &elementNodalStresses[( i * nNodes + j ) * 6] );
+        nodalCounts[node]++;
+      }
+    }
+
+    for ( int node = 0; node < nGlobalNodes; node++ )
+      if ( nodalCounts[node] > 0 )
+        nodalStressesMap.col( node ) /= nodalCounts[node];
+  }
+
+  template < int nDim, int nNodes, class Material >
+  double DisplacementFiniteElementBlock< nDim, nNodes, Material >::computeStressErrorIndicators(
+    const int*    connectivity,
+    const double* nodalStresses,
+    double*       errorIndicators )
+  {
+    double errorSquared  = 0.0;
+    double stressSquared = 0.0;
+
+#pragma omp parallel for schedule( static ) reduction( + : errorSquared, stressSquared )
+    for ( size_t i = 0; i < elements.size(); i++ ) {
+      if ( !elements[i]->isActive() ) {
+        errorIndicators[i] = 0.0;
+        continue;
+      }
+
+      Matrix< double, 6, nNodes > elementNodalStresses;
+      for ( int j = 0; j < nNodes; j++ )
+        elementNodalStresses.col( j ) = Map< const Vector6d >( &nodalStresses[connectivity[i * nNodes + j] * 6] );
+
+      const StressErrorIndicator indicator = elements[i]->computeStressErrorIndicator( elementNodalStresses.data() );
+
+      errorIndicators[i] = std::sqrt( indicator.errorSquared );
+      errorSquared += indicator.errorSquared;
+      stressSquared += indicator.stressSquared;
+    }
+
+    return errorSquared + stressSquared > 0 ? std::sqrt( errorSquared / ( errorSquared + stressSquared ) ) : 0.0;
+  }
+
+  template < int nDim, int nNodes, class Material >
+  IntegratedQuantities DisplacementFiniteElementBlock< nDim, nNodes, Material >::computeIntegratedQuantities()
+  {
+    double volume                = 0.0;
+    double strainEnergyIncrement = 0.0;
+    double stressIntegral[6]     = { 0.0 };
+
+#pragma omp parallel for schedule( static ) reduction( + : volume, strainEnergyIncrement, stressIntegral[:6] )
+    for ( size_t i = 0; i < elements.size(); i++ ) {
+      const IntegratedQuantities& elementQuantities = elements[i]->getIntegratedQuantities();
+
+      volume += elementQuantities.volume;
+      strainEnergyIncrement += elementQuantities.strainEnergyIncrement;
+      for ( int j = 0; j < 6; j++ )
+        stressIntegral[j] += elementQuantities.stressIntegral( j );
+    }
+
+    IntegratedQuantities quantities;
+    quantities.volume                = volume;
+    quantities.strainEnergyIncrement = strainEnergyIncrement;
+    quantities.stressIntegral        = Map< const Vector6d >( stressIntegral );
+    return quantities;
+  }
+
+} // namespace Marmot::Elements
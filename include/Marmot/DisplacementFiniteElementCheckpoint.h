@@ -0,0 +1,302 @@
+/* ---------------------------------------------------------------------
+ *                                       _
+ *  _ __ ___   __ _ _ __ _ __ ___   ___ | |_
+ * | '_ ` _ \ / _` | '__| '_ ` _ \ / _ \| __|
+ * | | | | | | (_| | |  | | | | | | (_) | |_
+ * |_| |_| |_|\__,_|_|  |_| |_| |_|\___/ \__|
+ *
+ * Unit of Strength of Materials and Structural Analysis
+ * University of Innsbruck,
+ * 2020 - today
+ *
+ * festigkeitslehre@uibk.ac.at
+ *
+ * Matthias Neuner matthias.neuner@uibk.ac.at
+ * Magdalena Schreter magdalena.schreter@uibk.ac.at
+ *
+ * This file is part of the MAteRialMOdellingToolbox (marmot).
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * The full text of the license can be found in the file LICENSE.md at
+ * the top level directory of marmot.
+ * ---------------------------------------------------------------------
+ */
+#pragma once
+#include "Marmot/DisplacementFiniteElement.h"
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace Marmot::Elements::Checkpoint {
+
+  /* Binary checkpoint of DisplacementFiniteElements.
+   *
+   * Layout of a checkpoint file:
+   *  - FileHeader
+   *  - ElementRecord[nElements]
+   *  - state vars of all elements, contiguous, starting at a page boundary
+   *  - geometry (cf. DisplacementFiniteElement::exportGeometry, including the quadrature point mask)
+   *    of all elements, contiguous
+   *
+   * On restart, the file is memory-mapped privately (copy-on-write), and the state vars of the elements
+   * are bound directly to the mapped region via assignStateVars; nothing is parsed or copied.
+   *
+   * Layout of an incremental checkpoint file:
+   *  - IncrementHeader
+   *  - for each changed element: IncrementRecord, followed by its state vars
+   *
+   * An incremental checkpoint only holds the elements which changed since the previous (full or
+   * incremental) checkpoint, and it is applied onto the mapped full checkpoint on restart.
+   *
+   * Both record types hold the activation and erosion state of the element (cf. ElementFlags),
+   * which is restored together with the state vars.
+   * */
+
+  constexpr char     fileMagic[8]          = { 'M', 'A', 'R', 'M', 'O', 'T', 'C', 'P' };
+  constexpr char     incrementFileMagic[8] = { 'M', 'A', 'R', 'M', 'O', 'T', 'C', 'I' };
+  constexpr uint32_t fileVersion           = 3;
+
+  enum ElementFlags : uint32_t {
+    isActiveFlag = 1 << 0,
+    isErodedFlag = 1 << 1,
+  };
+
+  struct FileHeader {
+    char     magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t nElements;
+    uint64_t nStateVars;
+    uint64_t nGeometryEntries;
+    uint64_t stateVarsOffset;
+    uint64_t geometryOffset;
+  };
+
+  struct ElementRecord {
+    int32_t  elLabel;
+    int32_t  nDim;
+    int32_t  nNodes;
+    int32_t  nQuadraturePoints;
+    int32_t  nStateVars;
+    int32_t  nGeometryEntries;
+    uint32_t flags;
+    uint32_t reserved;
+    uint64_t stateVarsOffset;
+    uint64_t geometryOffset;
+  };
+
+  struct IncrementHeader {
+    char     magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t nRecords;
+  };
+
+  struct IncrementRecord {
+    uint64_t elementIndex;
+    int64_t  nStateVars;
+    uint32_t flags;
+    uint32_t reserved;
+  };
+
+  /* state of an element at the time a checkpoint is written */
+  struct ElementState {
+    const double*       stateVars;
+    int                 nStateVars;
+    uint32_t            flags;
+    StateChangeTracker* stateChange;
+  };
+
+  /* type erased reference to an added element, which is queried whenever a checkpoint is written;
+   * hence, the state vars of the element may be reassigned or relocated,
+   * and its quadrature point mask may be changed after it is added */
+  struct ElementHandle {
+    void* element;
+    ElementState ( *getState )( void* element );
+    void ( *exportGeometry )( void* element, double* geometry );
+
+    template < int nDim, int nNodes >
+    static ElementHandle make( DisplacementFiniteElement< nDim, nNodes >& element )
+    {
+      using Element = DisplacementFiniteElement< nDim, nNodes >;
+
+      return { &element,
+               []( void* element ) -> ElementState {
+                 auto& theElement = *static_cast< Element* >( element );
+                 return { theElement.elementStateVars,
+                          theElement.nElementStateVars,
+                          ( theElement.isActive() ? isActiveFlag : 0u ) |
+                            ( theElement.isEroded() ? isErodedFlag : 0u ),
+                          &theElement.stateChangeSinceCheckpoint };
+               },
+               []( void* element, double* geometry ) { static_cast< Element* >( element )->exportGeometry( geometry ); } };
+    }
+
+    ElementState get() const { return getState( element ); }
+
+    void getGeometry( double* geometry ) const { exportGeometry( element, geometry ); }
+  };
+
+  /* The elements must outlive the writer, and their number of state vars must not change after they are added. */
+  class Writer {
+
+    std::vector< ElementRecord > records;
+    std::vector< ElementHandle > elements;
+    uint64_t                     nGeometryEntries = 0;
+
+  public:
+    template < int nDim, int nNodes >
+    void addElement( DisplacementFiniteElement< nDim, nNodes >& element );
+
+    /* write the checkpoint; the state vars and the geometry are read at this point, not when the elements are added */
+    void write( const std::string& fileName ) const;
+  };
+
+  class MappedCheckpoint {
+
+    void*                mapping;
+    size_t               mappingSize;
+    const FileHeader*    header;
+    ElementRecord*       records;
+    double*              stateVars;
+    const double*        geometry;
+
+  public:
+    /* the mapping must outlive all elements bound to it */
+    explicit MappedCheckpoint( const std::string& fileName );
+
+    ~MappedCheckpoint();
+
+    MappedCheckpoint( const MappedCheckpoint& )            = delete;
+    MappedCheckpoint& operator=( const MappedCheckpoint& ) = delete;
+
+    size_t getNumberOfElements() const { return header->nElements; }
+
+    const ElementRecord& getRecord( size_t i ) const { return records[i]; }
+
+    double* getStateVars( size_t i ) { return stateVars + records[i].stateVarsOffset; }
+
+    const double* getGeometry( size_t i ) const { return geometry + records[i].geometryOffset; }
+
+    /* overwrite the mapped state vars and flags with the records of an incremental checkpoint */
+    void applyIncrement( const std::string& fileName );
+
+    /* restore the geometry of record i, which replaces initializeYourself on restart */
+    template < int nDim, int nNodes >
+    void restoreGeometry( size_t i, DisplacementFiniteElement< nDim, nNodes >& element );
+
+    /* bind the state vars of record i, which replaces assignStateVars on restart,
+     * and restore the activation and erosion state;
+     * as for assignStateVars, the material section must be assigned beforehand */
+    template < int nDim, int nNodes >
+    void bindStateVars( size_t i, DisplacementFiniteElement< nDim, nNodes >& element );
+
+  private:
+    /* the header and all records refer to sections within the mapping */
+    bool isConsistent() const;
+
+    template < int nDim, int nNodes >
+    void checkRecord( size_t i, DisplacementFiniteElement< nDim, nNodes >& element ) const;
+  };
+
+  /* A series of checkpoints, consisting of periodic full snapshots and incremental checkpoints in between,
+   * which only contain the elements with a state change exceeding the given tolerances.
+   * Files are named <baseName>.<number>.full and <baseName>.<number>.incr;
+   * a restart maps the last full snapshot and applies all subsequent increments in order.
+   * */
+  class Series {
+
+    const std::string             baseName;
+    const int                     fullSnapshotInterval;
+    const double                  strainTolerance;
+    const double                  stressTolerance;
+    int                           nWritten;
+    Writer                        fullSnapshotWriter;
+    std::vector< ElementHandle >  elements;
+
+  public:
+    Series( const std::string& baseName, int fullSnapshotInterval, double strainTolerance, double stressTolerance );
+
+    template < int nDim, int nNodes >
+    void addElement( DisplacementFiniteElement< nDim, nNodes >& element );
+
+    /* write the next checkpoint of the series, and return its file name */
+    std::string write();
+
+  private:
+    void writeIncrement( const std::string& fileName ) const;
+  };
+
+  template < int nDim, int nNodes >
+  void Writer::addElement( DisplacementFiniteElement< nDim, nNodes >& element )
+  {
+    if ( !element.elementStateVars )
+      throw std::invalid_argument( MakeString() << __PRETTY_FUNCTION__ << ": element " << element.elLabel
+                                                << " has no state vars assigned" );
+
+    ElementRecord record;
+    record.elLabel           = element.elLabel;
+    record.nDim              = nDim;
+    record.nNodes            = nNodes;
+    record.nQuadraturePoints = element.getNumberOfQuadraturePoints();
+    record.nStateVars        = element.nElementStateVars;
+    record.nGeometryEntries  = element.getNumberOfGeometryEntries();
+    record.flags             = 0;
+    record.reserved          = 0;
+    record.stateVarsOffset   = records.empty() ? 0 : records.back().stateVarsOffset + records.back().nStateVars;
+    record.geometryOffset    = nGeometryEntries;
+
+    nGeometryEntries += record.nGeometryEntries;
+
+    records.push_back( record );
+    elements.push_back( ElementHandle::make( element ) );
+  }
+
+  template < int nDim, int nNodes >
+  void Series::addElement( DisplacementFiniteElement< nDim, nNodes >& element )
+  {
+    fullSnapshotWriter.addElement( element );
+    elements.push_back( ElementHandle::make( element ) );
+  }
+
+  template < int nDim, int nNodes >
+  void MappedCheckpoint::restoreGeometry( size_t i, DisplacementFiniteElement< nDim, nNodes >& element )
+  {
+    checkRecord( i, element );
+    element.importGeometry( getGeometry( i ) );
+  }
+
+  template < int nDim, int nNodes >
+  void MappedCheckpoint::bindStateVars( size_t i, DisplacementFiniteElement< nDim, nNodes >& element )
+  {
+    checkRecord( i, element );
+
+    // the layout of the state vars depends on the assigned material section
+    if ( records[i].nStateVars != element.getNumberOfRequiredStateVars() )
+      throw std::invalid_argument( MakeString() << __PRETTY_FUNCTION__ << ": checkpoint record " << i << " holds "
+                                                << records[i].nStateVars << " state vars, but element "
+                                                << element.elLabel << " requires "
+                                                << element.getNumberOfRequiredStateVars() );
+
+    element.assignStateVars( getStateVars( i ), records[i].nStateVars );
+    element.restoreActivationState( records[i].flags & isActiveFlag, records[i].flags & isErodedFlag );
+  }
+
+  template < int nDim, int nNodes >
+  void MappedCheckpoint::checkRecord( size_t i, DisplacementFiniteElement< nDim, nNodes >& element ) const
+  {
+    const ElementRecord& record = records[i];
+
+    if ( record.elLabel != element.elLabel || record.nDim != nDim || record.nNodes != nNodes ||
+         record.nQuadraturePoints != element.getNumberOfQuadraturePoints() ||
+         record.nGeometryEntries != element.getNumberOfGeometryEntries() )
+      throw std::invalid_argument( MakeString() << __PRETTY_FUNCTION__ << ": checkpoint record " << i
+                                                << " does not match element " << element.elLabel );
+  }
+
+} // namespace Marmot::Elements::Checkpoint
@@ -0,0 +1,47 @@
+/* ---------------------------------------------------------------------
+ *                                       _
+ *  _ __ ___   __ _ _ __ _ __ ___   ___ | |_
+ * | '_ ` _ \ / _` | '__| '_ ` _ \ / _ \| __|
+ * | | | | | | (_| | |  | | | | | | (_) | |_
+ * |_| |_| |_|\__,_|_|  |_| |_| |_|\___/ \__|
+ *
+ * Unit of Strength of Materials and Structural Analysis
+ * University of Innsbruck,
+ * 2020 - today
+ *
+ * festigkeitslehre@uibk.ac.at
+ *
+ * Matthias Neuner matthias.neuner@uibk.ac.at
+ * Magdalena Schreter magdalena.schreter@uibk.ac.at
+ *
+ * This file is part of the MAteRialMOdellingToolbox (marmot).
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * The full text of the license can be found in the file LICENSE.md at
+ * the top level directory of marmot.
+ * ---------------------------------------------------------------------
+ */
+#pragma once
+#include <Eigen/Core>
+
+namespace Marmot::Elements::HyperReduction {
+
+  /* Offline selection of a reduced quadrature by energy-conserving sampling and weighting.
+   *
+   * Each column j of G holds the contribution of a candidate quadrature point (or element) j
+   * to the training quantities, e.g., the internal forces of all training snapshots projected onto a reduced basis,
+   * weighted with the full order J0xW (cf. DisplacementFiniteElement::computeQuadraturePointInternalForces).
+   * The full order integral is b = G * 1.
+   *
+   * A sparse vector of non-negative factors xi is determined by the Lawson-Hanson non-negative least squares
+   * algorithm, which is terminated as soon as || G * xi - b || <= tolerance * || b ||.
+   * The candidates with xi_j > 0 form the reduced quadrature, with the J0xW overrides xi_j * J0xW_j
+   * (cf. DisplacementFiniteElement::setQuadraturePointMask).
+   * */
+  Eigen::VectorXd selectReducedQuadrature( const Eigen::MatrixXd& G, double tolerance, int maxIterations );
+
+} // namespace Marmot::Elements::HyperReduction
@@ -0,0 +1,139 @@
+/* ---------------------------------------------------------------------
+ *                                       _
+ *  _ __ ___   __ _ _ __ _ __ ___   ___ | |_
+ * | '_ ` _ \ / _` | '__| '_ ` _ \ / _ \| __|
+ * | | | | | | (_| | |  | | | | | | (_) | |_
+ * |_| |_| |_|\__,_|_|  |_| |_| |_|\___/ \__|
+ *
+ * Unit of Strength of Materials and Structural Analysis
+ * University of Innsbruck,
+ * 2020 - today
+ *
+ * festigkeitslehre@uibk.ac.at
+ *
+ * Matthias Neuner matthias.neuner@uibk.ac.at
+ * Magdalena Schreter magdalena.schreter@uibk.ac.at
+ *
+ * This file is part of the MAteRialMOdellingToolbox (marmot).
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * The full text of the license can be found in the file LICENSE.md at
+ * the top level directory of marmot.
+ * ---------------------------------------------------------------------
+ */
+#pragma once
+#include <Eigen/Core>
+
+namespace Marmot::Elements::DisplacementFiniteElementKernels {
+
+  /* Sparsity pattern of the small strain operator B in Voigt notation (11, 22, 33, 12, 13, 23),
+   * with engineering shear strains.
+   * The column of B belonging to the displacement direction d of node a
+   * only populates the rows nonZeroRows[d][:], holding the shape function derivatives
+   * dN_a/dX_k with k = derivativeDirections[d][:].
+   * */
+  template < int nDim >
+  struct BPattern;
+
+  template <>
+  struct BPattern< 1 > {
+    static constexpr int nNonZeroRows                          = 1;
+    static constexpr int nonZeroRows[1][nNonZeroRows]          = { { 0 } };
+    static constexpr int derivativeDirections[1][nNonZeroRows] = { { 0 } };
+  };
+
+  template <>
+  struct BPattern< 2 > {
+    static constexpr int nNonZeroRows                          = 2;
+    static constexpr int nonZeroRows[2][nNonZeroRows]          = { { 0, 2 }, { 1, 2 } };
+    static constexpr int derivativeDirections[2][nNonZeroRows] = { { 0, 1 }, { 1, 0 } };
+  };
+
+  template <>
+  struct BPattern< 3 > {
+    static constexpr int nNonZeroRows                          = 3;
+    static constexpr int nonZeroRows[3][nNonZeroRows]          = { { 0, 3, 4 }, { 1, 3, 5 }, { 2, 4, 5 } };
+    static constexpr int derivativeDirections[3][nNonZeroRows] = { { 0, 1, 2 }, { 1, 0, 2 }, { 2, 0, 1 } };
+  };
+
+  /* Closed form element kernels, which exploit the known dimensions and the zero pattern of B.
+   * Instead of the dense products with B, the kernels operate on the nNodes x nDim
+   * shape function derivatives contained in B, vectorized over the element nodes.
+   * All loop bounds are compile time constants, hence the kernels are fully unrolled by the compiler.
+   * */
+  template < int nDim, int nNodes >
+  struct ClosedForm {
+
+    static constexpr int nDof      = nDim * nNodes;
+    static constexpr int voigtSize = ( nDim * nDim + nDim ) / 2;
+
+    using Pattern     = BPattern< nDim >;
+    using dNdXTSized  = Eigen::Matrix< double, nNodes, nDim >;
+    using NodalVector = Eigen::Matrix< double, nNodes, 1 >;
+
+    /* extract the shape function derivatives dN_a/dX_k from the normal strain rows of B */
+    template < class BType >
+    static dNdXTSized extractShapeFunctionDerivatives( const BType& B )
+    {
+      dNdXTSized G;
+      for ( int a = 0; a < nNodes; a++ )
+        for ( int k = 0; k < nDim; k++ )
+          G( a, k ) = B( k, nDim * a + k );
+      return G;
+    }
+
+    /* Ke += B^T * C * B * J0xW */
+    template < class BType, class CType, class KeType >
+    static void accumulateStiffness( const BType& B, const CType& C, double J0xW, KeType& Ke )
+    {
+      constexpr int nNZ = Pattern::nNonZeroRows;
+      const auto&   row = Pattern::nonZeroRows;
+      const auto&   dir = Pattern::derivativeDirections;
+
+      const dNdXTSized G = extractShapeFunctionDerivatives( B );
+
+      Eigen::Matrix< double, voigtSize, nDof > CB;
+      for ( int a = 0; a < nNodes; a++ )
+        for ( int d = 0; d < nDim; d++ ) {
+          CB.col( nDim * a + d ) = C.col( row[d][0] ) * ( G( a, dir[d][0] ) * J0xW );
+          for ( int m = 1; m < nNZ; m++ )
+            CB.col( nDim * a + d ) += C.col( row[d][m] ) * ( G( a, dir[d][m] ) * J0xW );
+        }
+
+      for ( int j = 0; j < nDof; j++ )
+        for ( int d = 0; d < nDim; d++ ) {
+          NodalVector KdJ = G.col( dir[d][0] ) * CB( row[d][0], j );
+          for ( int m = 1; m < nNZ; m++ )
+            KdJ += G.col( dir[d][m] ) * CB( row[d][m], j );
+
+          for ( int a = 0; a < nNodes; a++ )
+            Ke( nDim * a + d, j ) += KdJ( a );
+        }
+    }
+
+    /* Pe -= B^T * S * J0xW */
+    template < class BType, class SType, class PeType >
+    static void accumulateInternalForce( const BType& B, const SType& S, double J0xW, PeType& Pe )
+    {
+      constexpr int nNZ = Pattern::nNonZeroRows;
+      const auto&   row = Pattern::nonZeroRows;
+      const auto&   dir = Pattern::derivativeDirections;
+
+      const dNdXTSized G = extractShapeFunctionDerivatives( B );
+
+      for ( int d = 0; d < nDim; d++ ) {
+        NodalVector Pd = G.col( dir[d][0] ) * S( row[d][0] );
+        for ( int m = 1; m < nNZ; m++ )
+          Pd += G.col( dir[d][m] ) * S( row[d][m] );
+
+        for ( int a = 0; a < nNodes; a++ )
+          Pe( nDim * a + d ) -= Pd( a ) * J0xW;
+      }
+    }
+  };
+
+} // namespace Marmot::Elements::DisplacementFiniteElementKernels
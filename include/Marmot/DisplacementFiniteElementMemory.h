@@ -0,0 +1,97 @@
+/* ---------------------------------------------------------------------
+ *                                       _
+ *  _ __ ___   __ _ _ __ _ __ ___   ___ | |_
+ * | '_ ` _ \ / _` | '__| '_ ` _ \ / _ \| __|
+ * | | | | | | (_| | |  | | | | | | (_) | |_
+ * |_| |_| |_|\__,_|_|  |_| |_| |_|\___/ \__|
+ *
+ * Unit of Strength of Materials and Structural Analysis
+ * University of Innsbruck,
+ * 2020 - today
+ *
+ * festigkeitslehre@uibk.ac.at
+ *
+ * Matthias Neuner matthias.neuner@uibk.ac.at
+ * Magdalena Schreter magdalena.schreter@uibk.ac.at
+ *
+ * This file is part of the MAteRialMOdellingToolbox (marmot).
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * The full text of the license can be found in the file LICENSE.md at
+ * the top level directory of marmot.
+ * ---------------------------------------------------------------------
+ */
+#pragma once
+#include <cstddef>
+#include <memory_resource>
+#include <mutex>
+#include <vector>
+
+namespace Marmot::Elements::Memory {
+
+  enum class HugePages {
+    None,
+    Transparent,
+    Explicit,
+  };
+
+  /* Arena for the bulk data of large numbers of elements, i.e., their quadrature point geometry
+   * (cf. the memory resource of DisplacementFiniteElement) and their state vars,
+   * optionally backed by 2 MB huge pages for fewer TLB misses in sweeps over large models:
+   *  - Transparent: chunks are aligned to 2 MB and advised for transparent huge pages
+   *  - Explicit: chunks are taken from the reserved huge page pool (MAP_HUGETLB);
+   *    if the pool is exhausted, the chunk falls back to transparent huge pages
+   *
+   * Memory is handed out monotonically, and it is released only on destruction of the arena,
+   * which must hence outlive all elements and state vars allocated from it.
+   * Allocations are thread safe.
+   * */
+  class HugePageArena : public std::pmr::memory_resource {
+
+  public:
+    static constexpr size_t hugePageSize = size_t( 2 ) << 20;
+
+    explicit HugePageArena( HugePages hugePages = HugePages::Transparent, size_t chunkSize = 64 * hugePageSize );
+
+    ~HugePageArena();
+
+    HugePageArena( const HugePageArena& )            = delete;
+    HugePageArena& operator=( const HugePageArena& ) = delete;
+
+    /* state vars of nStateVars doubles, aligned to a cache line */
+    double* allocateStateVars( size_t nStateVars );
+
+    size_t getNumberOfReservedBytes() const { return nReservedBytes; }
+
+    /* bytes reserved from the huge page pool; the remainder uses transparent huge pages or normal pages */
+    size_t getNumberOfExplicitHugePageBytes() const { return nExplicitHugePageBytes; }
+
+  private:
+    struct Chunk {
+      void*  memory;
+      size_t size;
+    };
+
+    const HugePages      hugePages;
+    const size_t         chunkSize;
+    std::vector< Chunk > chunks;
+    char*                current;
+    size_t               nRemainingBytes;
+    size_t               nReservedBytes;
+    size_t               nExplicitHugePageBytes;
+    std::mutex           mutex;
+
+    void allocateChunk( size_t minimumSize );
+
+    void* do_allocate( size_t bytes, size_t alignment ) override;
+
+    void do_deallocate( void*, size_t, size_t ) override{};
+
+    bool do_is_equal( const std::pmr::memory_resource& other ) const noexcept override { return this == &other; }
+  };
+
+} // namespace Marmot::Elements::Memory
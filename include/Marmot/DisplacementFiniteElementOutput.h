@@ -0,0 +1,157 @@
+/* ---------------------------------------------------------------------
+ *                                       _
+ *  _ __ ___   __ _ _ __ _ __ ___   ___ | |_
+ * | '_ ` _ \ / _` | '__| '_ ` _ \ / _ \| __|
+ * | | | | | | (_| | |  | | | | | | (_) | |_
+ * |_| |_| |_|\__,_|_|  |_| |_| |_|\___/ \__|
+ *
+ * Unit of Strength of Materials and Structural Analysis
+ * University of Innsbruck,
+ * 2020 - today
+ *
+ * festigkeitslehre@uibk.ac.at
+ *
+ * Matthias Neuner matthias.neuner@uibk.ac.at
+ * Magdalena Schreter magdalena.schreter@uibk.ac.at
+ *
+ * This file is part of the MAteRialMOdellingToolbox (marmot).
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * The full text of the license can be found in the file LICENSE.md at
+ * the top level directory of marmot.
+ * ---------------------------------------------------------------------
+ */
+#pragma once
+#include "Marmot/DisplacementFiniteElement.h"
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Marmot::Elements::Output {
+
+  /* Streaming columnar output of quadrature point fields.
+   *
+   * Layout of an output file:
+   *  - FileHeader
+   *  - column names, each terminated by '\0', e.g. "stress[0]"
+   *  - for each frame: FrameHeader, followed by nColumns columns of nRows doubles each
+   *
+   * A row corresponds to a quadrature point, in the order the elements were added to the writer.
+   * A column corresponds to one component of a field.
+   * */
+
+  constexpr char     fileMagic[8] = { 'M', 'A', 'R', 'M', 'O', 'T', 'Q', 'O' };
+  constexpr uint32_t fileVersion  = 1;
+
+  struct FileHeader {
+    char     magic[8];
+    uint32_t version;
+    uint32_t nColumns;
+  };
+
+  struct FrameHeader {
+    double   time;
+    uint64_t nRows;
+  };
+
+  /* The locations of the fields are resolved once, when an element is added, as offsets into its state vars;
+   * elements must therefore be added after their state vars are assigned.
+   * The state vars of the elements are looked up again in each writeFrame, hence they may be reassigned or
+   * relocated (cf. DisplacementFiniteElementBlock::relocateStateVars) as long as their layout is unchanged.
+   * The added elements must outlive the writer, or be removed by clear.
+   * writeFrame gathers the fields into a column buffer, which is written to the file by a background thread
+   * while the analysis continues.
+   * */
+  class QuadraturePointFieldWriter {
+
+    const std::vector< std::string > fieldNames;
+    std::vector< int >               fieldSizes;
+    std::vector< double* const* >    rowStateVars;
+    std::vector< ptrdiff_t >         fieldOffsets;
+    uint64_t                         nRows;
+
+    std::ofstream         file;
+    bool                  isHeaderWritten;
+    std::vector< double > gatherBuffer;
+    std::vector< double > writeBuffer;
+    FrameHeader           pendingFrame;
+    bool                  isFramePending;
+    bool                  isStopping;
+
+    std::mutex              mutex;
+    std::condition_variable condition;
+    std::thread             writerThread;
+
+  public:
+    QuadraturePointFieldWriter( const std::string& fileName, const std::vector< std::string >& fieldNames );
+
+    ~QuadraturePointFieldWriter();
+
+    QuadraturePointFieldWriter( const QuadraturePointFieldWriter& )            = delete;
+    QuadraturePointFieldWriter& operator=( const QuadraturePointFieldWriter& ) = delete;
+
+    template < int nDim, int nNodes >
+    void addElement( DisplacementFiniteElement< nDim, nNodes >& element );
+
+    /* remove all added elements, e.g., before adding a reordered set of elements; the column layout is kept */
+    void clear();
+
+    int getNumberOfColumns() const;
+
+    /* gather the fields of all added elements and hand them over to the background thread;
+     * blocks only if the previous frame is still being written */
+    void writeFrame( double time );
+
+    /* wait until all frames are written */
+    void flush();
+
+  private:
+    void writeHeader();
+
+    void writeFrames();
+  };
+
+  template < int nDim, int nNodes >
+  void QuadraturePointFieldWriter::addElement( DisplacementFiniteElement< nDim, nNodes >& element )
+  {
+    if ( !element.elementStateVars )
+      throw std::invalid_argument( MakeString() << __PRETTY_FUNCTION__ << ": element " << element.elLabel
+                                                << " has no state vars assigned" );
+
+    for ( int i = 0; i < element.getNumberOfQuadraturePoints(); i++ ) {
+      for ( size_t j = 0; j < fieldNames.size(); j++ ) {
+        const StateView view = element.getStateView( fieldNames[j], i );
+
+        if ( fieldSizes[j] == 0 && !isHeaderWritten )
+          fieldSizes[j] = view.stateSize;
+
+        else if ( fieldSizes[j] != view.stateSize )
+          throw std::invalid_argument( MakeString() << __PRETTY_FUNCTION__ << ": field " << fieldNames[j]
+                                                    << " of element " << element.elLabel
+                                                    << " does not match the column layout" );
+
+        const ptrdiff_t offset = view.stateLocation - element.elementStateVars;
+
+        if ( offset < 0 || offset + view.stateSize > element.nElementStateVars )
+          throw std::invalid_argument( MakeString() << __PRETTY_FUNCTION__ << ": field " << fieldNames[j]
+                                                    << " of element " << element.elLabel
+                                                    << " is not located in its state vars" );
+
+        fieldOffsets.push_back( offset );
+      }
+      rowStateVars.push_back( &element.elementStateVars );
+      nRows++;
+    }
+  }
+
+} // namespace Marmot::Elements::Output
@@ -0,0 +1,198 @@
+/* ---------------------------------------------------------------------
+ *                                       _
+ *  _ __ ___   __ _ _ __ _ __ ___   ___ | |_
+ * | '_ ` _ \ / _` | '__| '_ ` _ \ / _ \| __|
+ * | | | | | | (_| | |  | | | | | | (_) | |_
+ * |_| |_| |_|\__,_|_|  |_| |_| |_|\___/ \__|
+ *
+ * Unit of Strength of Materials and Structural Analysis
+ * University of Innsbruck,
+ * 2020 - today
+ *
+ * festigkeitslehre@uibk.ac.at
+ *
+ * Matthias Neuner matthias.neuner@uibk.ac.at
+ * Magdalena Schreter magdalena.schreter@uibk.ac.at
+ *
+ * This file is part of the MAteRialMOdellingToolbox (marmot).
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * The full text of the license can be found in the file LICENSE.md at
+ * the top level directory of marmot.
+ * ---------------------------------------------------------------------
+ */
+#pragma once
+#include "Marmot/DisplacementFiniteElement.h"
+#include <Eigen/Cholesky>
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+namespace Marmot::Elements {
+
+  /* Superelement of a patch of DisplacementFiniteElements (e.g., a repeated unit cell),
+   * with the interior degrees of freedom statically condensed onto the boundary nodes:
+   *
+   *  K_c = K_bb - K_bi * K_ii^-1 * K_ib
+   *  P_c = P_b  - K_bi * K_ii^-1 * P_i
+   *
+   * The patch is assembled once from the committed state of its elements (cf. computeCommittedResponse),
+   * which remains untouched, hence the condensed operator is exact for linear sections.
+   * It can be reused for all copies of the patch, which are congruent by translation.
+   * Degrees of freedom of the boundary are ordered node wise, in the order of the given boundary nodes.
+   * */
+  template < int nDim, int nNodes >
+  class DisplacementFiniteElementSuperelement {
+
+  public:
+    using Element = DisplacementFiniteElement< nDim, nNodes >;
+
+    /* connectivity holds the patch local node indices (0 ... nPatchNodes-1) of each element (nElements x nNodes);
+     * the boundary nodes must be distinct patch local node indices */
+    DisplacementFiniteElementSuperelement( const std::vector< Element* >& elements,
+                                           const std::vector< int >&      connectivity,
+                                           int                            nPatchNodes,
+                                           const std::vector< int >&      boundaryNodes,
+                                           const double*                  time,
+                                           double                         dT );
+
+    int getNumberOfBoundaryDofs() const { return nBoundaryDofs; }
+
+    int getNumberOfInteriorDofs() const { return nInteriorDofs; }
+
+    const MatrixXd& getCondensedStiffness() const { return condensedStiffness; }
+
+    const VectorXd& getCondensedLoad() const { return condensedLoad; }
+
+    /* Pb += P_c - K_c * dQb and Kb += K_c for a copy of the patch with the boundary increment dQb,
+     * in the same convention as DisplacementFiniteElement::computeYourself */
+    void computeYourself( const double* dQb, double* Pb, double* Kb ) const;
+
+    /* increment of the interior degrees of freedom, dQi = K_ii^-1 * ( P_i - K_ib * dQb ) */
+    void recoverInteriorDisplacements( const double* dQb, double* dQi ) const;
+
+  private:
+    int nBoundaryDofs;
+    int nInteriorDofs;
+
+    MatrixXd condensedStiffness;
+    VectorXd condensedLoad;
+
+    // dQi = interiorLoadResponse + interiorRecovery * dQb
+    MatrixXd interiorRecovery;
+    VectorXd interiorLoadResponse;
+  };
+
+  template < int nDim, int nNodes >
+  DisplacementFiniteElementSuperelement< nDim, nNodes >::DisplacementFiniteElementSuperelement(
+    const std::vector< Element* >& elements,
+    const std::vector< int >&      connectivity,
+    int                            nPatchNodes,
+    const std::vector< int >&      boundaryNodes,
+    const double*                  time,
+    double                         dT )
+    : nBoundaryDofs( nDim * boundaryNodes.size() ), nInteriorDofs( nDim * ( nPatchNodes - boundaryNodes.size() ) )
+  {
+    if ( connectivity.size() != elements.size() * nNodes )
+      throw std::invalid_argument( MakeString() << __PRETTY_FUNCTION__
+                                                << ": connectivity does not match the elements" );
+
+    for ( int node : connectivity )
+      if ( node < 0 || node >= nPatchNodes )
+        throw std::invalid_argument( MakeString() << __PRETTY_FUNCTION__ << ": connectivity holds node " << node
+                                                  << " outside of the " << nPatchNodes << " patch nodes" );
+
+    // patch node -> position in the condensed ordering, boundary nodes first
+    std::vector< int > nodeIndices( nPatchNodes, -1 );
+    for ( size_t i = 0; i < boundaryNodes.size(); i++ ) {
+      const int node = boundaryNodes[i];
+      if ( node < 0 || node >= nPatchNodes )
+        throw std::invalid_argument( MakeString() << __PRETTY_FUNCTION__ << ": boundary node " << node
+                                                  << " outside of the " << nPatchNodes << " patch nodes" );
+      if ( nodeIndices[node] >= 0 )
+        throw std::invalid_argument( MakeString() << __PRETTY_FUNCTION__ << ": duplicate boundary node " << node );
+
+      nodeIndices[node] = i;
+    }
+
+    int nextInteriorNode = boundaryNodes.size();
+    for ( int& nodeIndex : nodeIndices )
+      if ( nodeIndex < 0 )
+        nodeIndex = nextInteriorNode++;
+
+    const int nDofs = nBoundaryDofs + nInteriorDofs;
+    MatrixXd  K     = MatrixXd::Zero( nDofs, nDofs );
+    VectorXd  P     = VectorXd::Zero( nDofs );
+
+    for ( size_t e = 0; e < elements.size(); e++ ) {
+      typename Element::RhsSized      Pe = Element::RhsSized::Zero();
+      typename Element::KeSizedMatrix Ke = Element::KeSizedMatrix::Zero();
+
+      elements[e]->computeCommittedResponse( Pe.data(), Ke.data(), time, dT );
+
+      int dofs[Element::sizeLoadVector];
+      for ( int a = 0; a < nNodes; a++ )
+        for ( int d = 0; d < nDim; d++ )
+          dofs[nDim * a + d] = nDim * nodeIndices[connectivity[e * nNodes + a]] + d;
+
+      for ( int i = 0; i < Element::sizeLoadVector; i++ ) {
+        P( dofs[i] ) += Pe( i );
+        for ( int j = 0; j < Element::sizeLoadVector; j++ )
+          K( dofs[i], dofs[j] ) += Ke( i, j );
+      }
+    }
+
+    const auto Kbb = K.topLeftCorner( nBoundaryDofs, nBoundaryDofs );
+    const auto Kbi = K.topRightCorner( nBoundaryDofs, nInteriorDofs );
+    const auto Kib = K.bottomLeftCorner( nInteriorDofs, nBoundaryDofs );
+    const auto Kii = K.bottomRightCorner( nInteriorDofs, nInteriorDofs );
+
+    // LDLT succeeds for singular semidefinite matrices as well, hence the pivots are checked
+    const LDLT< MatrixXd > KiiFactorization( Kii );
+    if ( KiiFactorization.info() != Eigen::Success || !KiiFactorization.isPositive() )
+      throw std::invalid_argument( MakeString() << __PRETTY_FUNCTION__
+                                                << ": interior stiffness is not positive definite" );
+
+    if ( nInteriorDofs > 0 ) {
+      const VectorXd pivots = KiiFactorization.vectorD();
+      if ( pivots.minCoeff() <= nInteriorDofs * std::numeric_limits< double >::epsilon() * pivots.maxCoeff() )
+        throw std::invalid_argument( MakeString() << __PRETTY_FUNCTION__
+                                                  << ": interior stiffness is not positive definite" );
+    }
+
+    interiorRecovery     = -KiiFactorization.solve( MatrixXd( Kib ) );
+    interiorLoadResponse = KiiFactorization.solve( VectorXd( P.tail( nInteriorDofs ) ) );
+
+    condensedStiffness = Kbb + Kbi * interiorRecovery;
+    condensedLoad      = P.head( nBoundaryDofs ) - Kbi * interiorLoadResponse;
+  }
+
+  template < int nDim, int nNodes >
+  void DisplacementFiniteElementSuperelement< nDim, nNodes >::computeYourself( const double* dQb_,
+                                                                               double*       Pb_,
+                                                                               double*       Kb_ ) const
+  {
+    Map< const VectorXd > dQb( dQb_, nBoundaryDofs );
+    Map< VectorXd >       Pb( Pb_, nBoundaryDofs );
+    Map< MatrixXd >       Kb( Kb_, nBoundaryDofs, nBoundaryDofs );
+
+    Pb += condensedLoad - condensedStiffness * dQb;
+    Kb += condensedStiffness;
+  }
+
+  template < int nDim, int nNodes >
+  void DisplacementFiniteElementSuperelement< nDim, nNodes >::recoverInteriorDisplacements( const double* dQb_,
+                                                                                            double*       dQi_ ) const
+  {
+    Map< const VectorXd > dQb( dQb_, nBoundaryDofs );
+    Map< VectorXd >       dQi( dQi_, nInteriorDofs );
+
+    dQi = interiorLoadResponse + interiorRecovery * dQb;
+  }
+
+} // namespace Marmot::Elements
@@ -18,4 +18,16 @@ if ( DEPENDECIES_FULLFILLED )
     include_directories(${CMAKE_CURRENT_LIST_DIR}/include)
     file(GLOB sources_material "${CMAKE_CURRENT_LIST_DIR}/src/*.cpp")
     list(APPEND sources ${sources_material})
+
+    option(DISPLACEMENTFINITEELEMENT_SINGLE_PRECISION_GEOMETRY
+           "store the quadrature point geometry of DisplacementFiniteElements in single precision" OFF)
+
+    # the options change the layout of the elements, so they are recorded in an installed header
+    # rather than in compile definitions, which code built against the installed library would not see
+    set(DISPLACEMENTFINITEELEMENT_CONFIG_HEADER
+        "${CMAKE_CURRENT_BINARY_DIR}/include/Marmot/DisplacementFiniteElementConfig.h")
+    configure_file("${CMAKE_CURRENT_LIST_DIR}/include/Marmot/DisplacementFiniteElementConfig.h.in"
+                   ${DISPLACEMENTFINITEELEMENT_CONFIG_HEADER})
+    include_directories(${CMAKE_CURRENT_BINARY_DIR}/include)
+    install(FILES ${DISPLACEMENTFINITEELEMENT_CONFIG_HEADER} DESTINATION include/Marmot)
 endif()
@@ -0,0 +1,235 @@
+#include "Marmot/DisplacementFiniteElementCheckpoint.h"
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace Marmot::Elements::Checkpoint {
+
+  namespace {
+    constexpr uint64_t pageSize = 4096;
+
+    uint64_t alignToPage( uint64_t offset ) { return ( offset + pageSize - 1 ) / pageSize * pageSize; }
+  } // namespace
+
+  void Writer::write( const std::string& fileName ) const
+  {
+    std::vector< ElementState >  states( elements.size() );
+    std::vector< ElementRecord > currentRecords( records );
+    for ( size_t i = 0; i < elements.size(); i++ ) {
+      states[i] = elements[i].get();
+
+      if ( !states[i].stateVars || states[i].nStateVars != records[i].nStateVars )
+        throw std::invalid_argument( MakeString() << __PRETTY_FUNCTION__ << ": state vars of element "
+                                                  << records[i].elLabel << " changed since it was added" );
+
+      currentRecords[i].flags = states[i].flags;
+    }
+
+    FileHeader header;
+    std::memcpy( header.magic, fileMagic, sizeof( fileMagic ) );
+    header.version          = fileVersion;
+    header.reserved         = 0;
+    header.nElements        = records.size();
+    header.nStateVars       = records.empty() ? 0 : records.back().stateVarsOffset + records.back().nStateVars;
+    header.nGeometryEntries = nGeometryEntries;
+    header.stateVarsOffset  = alignToPage( sizeof( FileHeader ) + records.size() * sizeof( ElementRecord ) );
+    header.geometryOffset   = header.stateVarsOffset + header.nStateVars * sizeof( double );
+
+    std::ofstream file( fileName, std::ios::binary | std::ios::trunc );
+    if ( !file )
+      throw std::runtime_error( MakeString() << __PRETTY_FUNCTION__ << ": cannot open " << fileName );
+
+    file.write( reinterpret_cast< const char* >( &header ), sizeof( FileHeader ) );
+    file.write( reinterpret_cast< const char* >( currentRecords.data() ),
+                currentRecords.size() * sizeof( ElementRecord ) );
+
+    const std::vector< char > padding( header.stateVarsOffset - file.tellp(), 0 );
+    file.write( padding.data(), padding.size() );
+
+    for ( size_t i = 0; i < records.size(); i++ )
+      file.write( reinterpret_cast< const char* >( states[i].stateVars ), records[i].nStateVars * sizeof( double ) );
+
+    std::vector< double > geometry;
+    for ( size_t i = 0; i < records.size(); i++ ) {
+      geometry.resize( records[i].nGeometryEntries );
+      elements[i].getGeometry( geometry.data() );
+      file.write( reinterpret_cast< const char* >( geometry.data() ), geometry.size() * sizeof( double ) );
+    }
+
+    if ( !file )
+      throw std::runtime_error( MakeString() << __PRETTY_FUNCTION__ << ": failed writing " << fileName );
+  }
+
+  Series::Series( const std::string& baseName,
+                  int                fullSnapshotInterval,
+                  double             strainTolerance,
+                  double             stressTolerance )
+    : baseName( baseName ),
+      fullSnapshotInterval( fullSnapshotInterval ),
+      strainTolerance( strainTolerance ),
+      stressTolerance( stressTolerance ),
+      nWritten( 0 )
+  {
+    if ( fullSnapshotInterval < 1 )
+      throw std::invalid_argument( MakeString() << __PRETTY_FUNCTION__ << ": invalid full snapshot interval" );
+  }
+
+  std::string Series::write()
+  {
+    const bool        isFullSnapshot = nWritten % fullSnapshotInterval == 0;
+    const std::string fileName = MakeString() << baseName << "." << nWritten << ( isFullSnapshot ? ".full" : ".incr" );
+
+    if ( isFullSnapshot )
+      fullSnapshotWriter.write( fileName );
+    else
+      writeIncrement( fileName );
+
+    for ( const auto& element : elements ) {
+      StateChangeTracker& stateChange = *element.get().stateChange;
+      if ( isFullSnapshot || stateChange.exceeds( strainTolerance, stressTolerance ) )
+        stateChange.reset();
+    }
+
+    nWritten++;
+    return fileName;
+  }
+
+  void Series::writeIncrement( const std::string& fileName ) const
+  {
+    std::ofstream file( fileName, std::ios::binary | std::ios::trunc );
+    if ( !file )
+      throw std::runtime_error( MakeString() << __PRETTY_FUNCTION__ << ": cannot open " << fileName );
+
+    IncrementHeader header;
+    std::memcpy( header.magic, incrementFileMagic, sizeof( incrementFileMagic ) );
+    header.version  = fileVersion;
+    header.reserved = 0;
+    header.nRecords = 0;
+    file.write( reinterpret_cast< const char* >( &header ), sizeof( IncrementHeader ) );
+
+    for ( size_t i = 0; i < elements.size(); i++ ) {
+      const ElementState element = elements[i].get();
+      if ( !element.stateChange->exceeds( strainTolerance, stressTolerance ) )
+        continue;
+
+      const IncrementRecord record{ i, element.nStateVars, element.flags, 0 };
+      file.write( reinterpret_cast< const char* >( &record ), sizeof( IncrementRecord ) );
+      file.write( reinterpret_cast< const char* >( element.stateVars ), element.nStateVars * sizeof( double ) );
+      header.nRecords++;
+    }
+
+    file.seekp( 0 );
+    file.write( reinterpret_cast< const char* >( &header ), sizeof( IncrementHeader ) );
+
+    if ( !file )
+      throw std::runtime_error( MakeString() << __PRETTY_FUNCTION__ << ": failed writing " << fileName );
+  }
+
+  MappedCheckpoint::MappedCheckpoint( const std::string& fileName )
+    : mapping( MAP_FAILED ),
+      mappingSize( 0 ),
+      header( nullptr ),
+      records( nullptr ),
+      stateVars( nullptr ),
+      geometry( nullptr )
+  {
+    const int fd = open( fileName.c_str(), O_RDONLY );
+    if ( fd < 0 )
+      throw std::runtime_error( MakeString() << __PRETTY_FUNCTION__ << ": cannot open " << fileName );
+
+    struct stat fileStat;
+    if ( fstat( fd, &fileStat ) != 0 || static_cast< size_t >( fileStat.st_size ) < sizeof( FileHeader ) ) {
+      close( fd );
+      throw std::runtime_error( MakeString() << __PRETTY_FUNCTION__ << ": invalid checkpoint " << fileName );
+    }
+
+    mappingSize = fileStat.st_size;
+    // private mapping: the state vars may be modified by the restarted analysis without touching the file
+    mapping = mmap( nullptr, mappingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0 );
+    close( fd );
+
+    if ( mapping == MAP_FAILED )
+      throw std::runtime_error( MakeString() << __PRETTY_FUNCTION__ << ": cannot map " << fileName );
+
+    char* base = static_cast< char* >( mapping );
+    header     = reinterpret_cast< const FileHeader* >( base );
+    records    = reinterpret_cast< ElementRecord* >( base + sizeof( FileHeader ) );
+
+    if ( !isConsistent() ) {
+      munmap( mapping, mappingSize );
+      throw std::runtime_error( MakeString() << __PRETTY_FUNCTION__ << ": invalid checkpoint " << fileName );
+    }
+
+    stateVars = reinterpret_cast< double* >( base + header->stateVarsOffset );
+    geometry  = reinterpret_cast< const double* >( base + header->geometryOffset );
+  }
+
+  bool MappedCheckpoint::isConsistent() const
+  {
+    if ( std::memcmp( header->magic, fileMagic, sizeof( fileMagic ) ) != 0 || header->version != fileVersion )
+      return false;
+
+    // the sections must be ordered and within the mapping, with sizes checked before they are multiplied
+    const uint64_t maxEntries = mappingSize / sizeof( double );
+    if ( header->nElements > ( mappingSize - sizeof( FileHeader ) ) / sizeof( ElementRecord ) ||
+         header->nStateVars > maxEntries || header->nGeometryEntries > maxEntries ||
+         sizeof( FileHeader ) + header->nElements * sizeof( ElementRecord ) > header->stateVarsOffset ||
+         header->stateVarsOffset % sizeof( double ) != 0 || header->geometryOffset % sizeof( double ) != 0 ||
+         header->stateVarsOffset > header->geometryOffset ||
+         header->nStateVars * sizeof( double ) > header->geometryOffset - header->stateVarsOffset ||
+         header->geometryOffset > mappingSize ||
+         header->nGeometryEntries * sizeof( double ) > mappingSize - header->geometryOffset )
+      return false;
+
+    for ( uint64_t i = 0; i < header->nElements; i++ ) {
+      const ElementRecord& record = records[i];
+      if ( record.nStateVars < 0 || record.nGeometryEntries < 0 || record.stateVarsOffset > header->nStateVars ||
+           uint64_t( record.nStateVars ) > header->nStateVars - record.stateVarsOffset ||
+           record.geometryOffset > header->nGeometryEntries ||
+           uint64_t( record.nGeometryEntries ) > header->nGeometryEntries - record.geometryOffset )
+        return false;
+    }
+
+    return true;
+  }
+
+  void MappedCheckpoint::applyIncrement( const std::string& fileName )
+  {
+    std::ifstream file( fileName, std::ios::binary );
+
+    IncrementHeader incrementHeader;
+    file.read( reinterpret_cast< char* >( &incrementHeader ), sizeof( IncrementHeader ) );
+
+    if ( !file || std::memcmp( incrementHeader.magic, incrementFileMagic, sizeof( incrementFileMagic ) ) != 0 ||
+         incrementHeader.version != fileVersion )
+      throw std::runtime_error( MakeString() << __PRETTY_FUNCTION__ << ": invalid incremental checkpoint "
+                                             << fileName );
+
+    for ( uint64_t i = 0; i < incrementHeader.nRecords; i++ ) {
+      IncrementRecord record;
+      file.read( reinterpret_cast< char* >( &record ), sizeof( IncrementRecord ) );
+
+      if ( !file || record.elementIndex >= header->nElements ||
+           record.nStateVars != records[record.elementIndex].nStateVars )
+        throw std::runtime_error( MakeString() << __PRETTY_FUNCTION__ << ": incremental checkpoint " << fileName
+                                               << " does not match the mapped checkpoint" );
+
+      file.read( reinterpret_cast< char* >( getStateVars( record.elementIndex ) ),
+                 record.nStateVars * sizeof( double ) );
+      records[record.elementIndex].flags = record.flags;
+    }
+
+    if ( !file )
+      throw std::runtime_error( MakeString() << __PRETTY_FUNCTION__ << ": failed reading " << fileName );
+  }
+
+  MappedCheckpoint::~MappedCheckpoint()
+  {
+    if ( mapping != MAP_FAILED )
+      munmap( mapping, mappingSize );
+  }
+
+} // namespace Marmot::Elements::Checkpoint
@@ -0,0 +1,88 @@
+#include "Marmot/DisplacementFiniteElementHyperReduction.h"
+#include <Eigen/QR>
+#include <vector>
+
+namespace Marmot::Elements::HyperReduction {
+
+  Eigen::VectorXd selectReducedQuadrature( const Eigen::MatrixXd& G, double tolerance, int maxIterations )
+  {
+    using namespace Eigen;
+
+    const long          nCandidates = G.cols();
+    const VectorXd      b           = G.rowwise().sum();
+    const double        bNorm       = b.norm();
+    VectorXd            xi          = VectorXd::Zero( nCandidates );
+    VectorXd            residual    = b;
+    std::vector< bool > isSelected( nCandidates, false );
+    std::vector< long > selected;
+
+    for ( int iteration = 0; iteration < maxIterations && residual.norm() > tolerance * bNorm; iteration++ ) {
+
+      // the candidate with the largest positive gradient of the residual joins the selected set
+      const VectorXd gradient  = G.transpose() * residual;
+      long           candidate = -1;
+      for ( long j = 0; j < nCandidates; j++ )
+        if ( !isSelected[j] && gradient( j ) > 0 && ( candidate < 0 || gradient( j ) > gradient( candidate ) ) )
+          candidate = j;
+
+      if ( candidate < 0 )
+        break;
+
+      isSelected[candidate] = true;
+      selected.push_back( candidate );
+
+      while ( true ) {
+        // unconstrained least squares solution for the selected set
+        MatrixXd GSelected( G.rows(), selected.size() );
+        for ( size_t k = 0; k < selected.size(); k++ )
+          GSelected.col( k ) = G.col( selected[k] );
+
+        const VectorXd z = GSelected.colPivHouseholderQr().solve( b );
+
+        if ( ( z.array() > 0 ).all() ) {
+          for ( size_t k = 0; k < selected.size(); k++ )
+            xi( selected[k] ) = z( k );
+          break;
+        }
+
+        // step towards z as far as feasible, and drop the candidates which reach zero;
+        // only negative entries of z block the step (with a positive denominator, as xi >= 0),
+        // and vanishing ones are dropped after the full step
+        double alpha    = 1.0;
+        long   blocking = -1;
+        for ( size_t k = 0; k < selected.size(); k++ ) {
+          if ( z( k ) >= 0 )
+            continue;
+
+          const double alphaK = xi( selected[k] ) / ( xi( selected[k] ) - z( k ) );
+          if ( alphaK <= alpha ) {
+            alpha    = alphaK;
+            blocking = k;
+          }
+        }
+
+        std::vector< long > remaining;
+        for ( size_t k = 0; k < selected.size(); k++ ) {
+          xi( selected[k] ) += alpha * ( z( k ) - xi( selected[k] ) );
+
+          if ( static_cast< long >( k ) != blocking && xi( selected[k] ) > 0 )
+            remaining.push_back( selected[k] );
+
+          else {
+            xi( selected[k] )       = 0.0;
+            isSelected[selected[k]] = false;
+          }
+        }
+
+        selected = remaining;
+        if ( selected.empty() )
+          break;
+      }
+
+      residual = b - G * xi;
+    }
+
+    return xi;
+  }
+
+} // namespace Marmot::Elements::HyperReduction
@@ -0,0 +1,95 @@
+#include "Marmot/DisplacementFiniteElementMemory.h"
+#include <algorithm>
+#include <cstdint>
+#include <new>
+#include <sys/mman.h>
+
+namespace Marmot::Elements::Memory {
+
+  namespace {
+    size_t alignTo( size_t size, size_t alignment ) { return ( size + alignment - 1 ) / alignment * alignment; }
+  } // namespace
+
+  HugePageArena::HugePageArena( HugePages hugePages, size_t chunkSize )
+    : hugePages( hugePages ),
+      chunkSize( alignTo( chunkSize, hugePageSize ) ),
+      current( nullptr ),
+      nRemainingBytes( 0 ),
+      nReservedBytes( 0 ),
+      nExplicitHugePageBytes( 0 )
+  {
+  }
+
+  HugePageArena::~HugePageArena()
+  {
+    for ( const Chunk& chunk : chunks )
+      munmap( chunk.memory, chunk.size );
+  }
+
+  double* HugePageArena::allocateStateVars( size_t nStateVars )
+  {
+    return static_cast< double* >( allocate( nStateVars * sizeof( double ), 64 ) );
+  }
+
+  void HugePageArena::allocateChunk( size_t minimumSize )
+  {
+    const size_t size = std::max( chunkSize, alignTo( minimumSize, hugePageSize ) );
+
+#ifdef MAP_HUGETLB
+    if ( hugePages == HugePages::Explicit ) {
+      void* memory = mmap( nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0 );
+
+      if ( memory != MAP_FAILED ) {
+        chunks.push_back( { memory, size } );
+        current         = static_cast< char* >( memory );
+        nRemainingBytes = size;
+        nReservedBytes += size;
+        nExplicitHugePageBytes += size;
+        return;
+      }
+    }
+#endif
+
+    // over-allocate by one huge page for aligning the chunk to the huge page size
+    const size_t mappedSize = size + hugePageSize;
+    void*        memory     = mmap( nullptr, mappedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+
+    if ( memory == MAP_FAILED )
+      throw std::bad_alloc();
+
+    chunks.push_back( { memory, mappedSize } );
+
+    char* aligned = reinterpret_cast< char* >( alignTo( reinterpret_cast< uintptr_t >( memory ), hugePageSize ) );
+
+#ifdef MADV_HUGEPAGE
+    if ( hugePages != HugePages::None )
+      madvise( aligned, size, MADV_HUGEPAGE );
+#endif
+
+    current         = aligned;
+    nRemainingBytes = size;
+    nReservedBytes += size;
+  }
+
+  void* HugePageArena::do_allocate( size_t bytes, size_t alignment )
+  {
+    std::lock_guard< std::mutex > lock( mutex );
+
+    const auto getPadding = [&]() {
+      const uintptr_t address = reinterpret_cast< uintptr_t >( current );
+      return alignTo( address, alignment ) - address;
+    };
+
+    if ( !current || getPadding() + bytes > nRemainingBytes )
+      allocateChunk( bytes + alignment );
+
+    const size_t padding = getPadding();
+
+    void* memory = current + padding;
+    current += padding + bytes;
+    nRemainingBytes -= padding + bytes;
+
+    return memory;
+  }
+
+} // namespace Marmot::Elements::Memory
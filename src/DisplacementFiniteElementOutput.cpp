@@ -0,0 +1,128 @@
+#include "Marmot/DisplacementFiniteElementOutput.h"
+#include <cstring>
+#include <numeric>
+
+namespace Marmot::Elements::Output {
+
+  QuadraturePointFieldWriter::QuadraturePointFieldWriter( const std::string&                fileName,
+                                                          const std::vector< std::string >& fieldNames )
+    : fieldNames( fieldNames ),
+      fieldSizes( fieldNames.size(), 0 ),
+      nRows( 0 ),
+      file( fileName, std::ios::binary | std::ios::trunc ),
+      isHeaderWritten( false ),
+      pendingFrame{ 0.0, 0 },
+      isFramePending( false ),
+      isStopping( false )
+  {
+    if ( !file )
+      throw std::runtime_error( MakeString() << __PRETTY_FUNCTION__ << ": cannot open " << fileName );
+
+    writerThread = std::thread( &QuadraturePointFieldWriter::writeFrames, this );
+  }
+
+  QuadraturePointFieldWriter::~QuadraturePointFieldWriter()
+  {
+    {
+      std::unique_lock< std::mutex > lock( mutex );
+      condition.wait( lock, [this] { return !isFramePending; } );
+      isStopping = true;
+    }
+    condition.notify_all();
+    writerThread.join();
+  }
+
+  void QuadraturePointFieldWriter::clear()
+  {
+    rowStateVars.clear();
+    fieldOffsets.clear();
+    nRows = 0;
+  }
+
+  int QuadraturePointFieldWriter::getNumberOfColumns() const
+  {
+    return std::accumulate( fieldSizes.begin(), fieldSizes.end(), 0 );
+  }
+
+  void QuadraturePointFieldWriter::writeFrame( double time )
+  {
+    const size_t nFields   = fieldNames.size();
+    const int    nColumns  = getNumberOfColumns();
+    const size_t nRowsUsed = nRows;
+
+    gatherBuffer.resize( nColumns * nRowsUsed );
+
+    for ( size_t row = 0; row < nRowsUsed; row++ ) {
+      const double*    stateVars = *rowStateVars[row];
+      const ptrdiff_t* offsets   = &fieldOffsets[row * nFields];
+      size_t           column    = 0;
+      for ( size_t j = 0; j < nFields; j++ )
+        for ( int k = 0; k < fieldSizes[j]; k++, column++ )
+          gatherBuffer[column * nRowsUsed + row] = stateVars[offsets[j] + k];
+    }
+
+    {
+      std::unique_lock< std::mutex > lock( mutex );
+      condition.wait( lock, [this] { return !isFramePending; } );
+
+      if ( !isHeaderWritten )
+        writeHeader();
+
+      if ( !file )
+        throw std::runtime_error( MakeString() << __PRETTY_FUNCTION__ << ": failed writing output" );
+
+      std::swap( gatherBuffer, writeBuffer );
+      pendingFrame   = { time, nRowsUsed };
+      isFramePending = true;
+    }
+    condition.notify_all();
+  }
+
+  void QuadraturePointFieldWriter::flush()
+  {
+    std::unique_lock< std::mutex > lock( mutex );
+    condition.wait( lock, [this] { return !isFramePending; } );
+    file.flush();
+  }
+
+  void QuadraturePointFieldWriter::writeHeader()
+  {
+    FileHeader header;
+    std::memcpy( header.magic, fileMagic, sizeof( fileMagic ) );
+    header.version  = fileVersion;
+    header.nColumns = getNumberOfColumns();
+    file.write( reinterpret_cast< const char* >( &header ), sizeof( FileHeader ) );
+
+    for ( size_t j = 0; j < fieldNames.size(); j++ )
+      for ( int k = 0; k < fieldSizes[j]; k++ ) {
+        const std::string columnName = MakeString() << fieldNames[j] << "[" << k << "]";
+        file.write( columnName.c_str(), columnName.size() + 1 );
+      }
+
+    isHeaderWritten = true;
+  }
+
+  void QuadraturePointFieldWriter::writeFrames()
+  {
+    std::unique_lock< std::mutex > lock( mutex );
+
+    while ( true ) {
+      condition.wait( lock, [this] { return isFramePending || isStopping; } );
+
+      if ( !isFramePending )
+        break;
+
+      // the buffer is not touched by writeFrame while a frame is pending
+      lock.unlock();
+      file.write( reinterpret_cast< const char* >( &pendingFrame ), sizeof( FrameHeader ) );
+      file.write( reinterpret_cast< const char* >( writeBuffer.data() ), writeBuffer.size() * sizeof( double ) );
+      lock.lock();
+
+      isFramePending = false;
+      condition.notify_all();
+    }
+
+    file.flush();
+  }
+
+} // namespace Marmot::Elements::Output